@@ -0,0 +1,618 @@
+///////////////////////////////////////////////////////////////////////
+// A CPU encoder and decoder for BC1, BC3, BC5 and BC6H (see
+// blockcompress.h).
+//
+// Color blocks (BC1, and the color half of BC3) take their endpoints
+// from the principal axis of the block's colors, inset slightly, then
+// refit once by least squares given the chosen indices.  Single
+// channel blocks (BC4, used for BC3 alpha and twice over for BC5) use
+// the block's min and max with 8 interpolated values.  BC6H blocks
+// are fit the same way as BC1's, on the bits of the pixels' half
+// floats, which grow about as their logarithm.
+////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include "blockcompress.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLOCK_SSE
+#endif
+
+size_t BlockSize(const BlockFormat format, const int w, const int h)
+{
+    size_t blocks = (size_t)((w+3)/4)*((h+3)/4);
+    return blocks*(format == BLOCK_BC1 ? 8 : 16);
+}
+
+// Call f(first, last) over rows [0,rows) of blocks, shared out among
+// the hardware threads.  Small images are not worth a thread.
+template<class F> static void ShareRows(const int rows, F f)
+{
+    int threads = std::max(1, std::min((int)std::thread::hardware_concurrency(), rows/16));
+    int step = (rows + threads-1)/threads;
+
+    std::vector<std::thread> workers;
+    for (int r=step;  r<rows;  r+=step)
+        workers.push_back(std::thread(f, r, std::min(rows, r+step)));
+    f(0, std::min(rows, step));
+    for (size_t i=0;  i<workers.size();  i++)
+        workers[i].join();
+}
+
+// Copy block (bx,by) of a w by h image into 16 RGBA pixels.
+static void GetBlock(const unsigned char* rgba, const int w, const int h,
+                     const int bx, const int by, unsigned char block[64])
+{
+    for (int y=0;  y<4;  y++) {
+        const unsigned char* row = rgba + (size_t)std::min(4*by+y, h-1)*w*4;
+        for (int x=0;  x<4;  x++)
+            memcpy(block + 16*y + 4*x, row + 4*std::min(4*bx+x, w-1), 4); }
+}
+
+////////////////////////////////////////////////////////////////////////
+// BC4:  one channel, taken from every fourth byte of v.
+
+static void EncodeBC4(const unsigned char* v, unsigned char out[8])
+{
+    int lo = 255, hi = 0;
+    for (int i=0;  i<16;  i++) {
+        lo = std::min(lo, (int)v[4*i]);
+        hi = std::max(hi, (int)v[4*i]); }
+
+    // With hi > lo the palette runs from hi (index 0) through six
+    // interpolated values (indices 2..7) to lo (index 1).
+    out[0] = hi;
+    out[1] = lo;
+    uint64_t bits = 0;
+    if (hi > lo)
+        for (int i=0;  i<16;  i++) {
+            int k = ((hi - v[4*i])*14 + (hi - lo))/(2*(hi - lo));  // Nearest of 8 steps
+            uint64_t index = k == 0 ? 0 : k == 7 ? 1 : k+1;
+            bits |= index << (3*i); }
+    for (int i=0;  i<6;  i++)
+        out[2+i] = (unsigned char)(bits >> (8*i));
+}
+
+////////////////////////////////////////////////////////////////////////
+// BC1:  RGB endpoints in 5:6:5 and a 2 bit index per pixel.
+
+// The 16 pixels of a block, one array per channel
+struct ColorBlock
+{
+    float r[16], g[16], b[16];
+};
+
+static int To565(const float r, const float g, const float b)
+{
+    int R = (int)(std::min(std::max(r, 0.0f), 255.0f)*31.0f/255.0f + 0.5f);
+    int G = (int)(std::min(std::max(g, 0.0f), 255.0f)*63.0f/255.0f + 0.5f);
+    int B = (int)(std::min(std::max(b, 0.0f), 255.0f)*31.0f/255.0f + 0.5f);
+    return (R << 11) | (G << 5) | B;
+}
+
+static void From565(const int c, float rgb[3])
+{
+    int R = (c >> 11) & 31, G = (c >> 5) & 63, B = c & 31;
+    rgb[0] = (float)((R << 3) | (R >> 2));
+    rgb[1] = (float)((G << 2) | (G >> 4));
+    rgb[2] = (float)((B << 3) | (B >> 2));
+}
+
+// Choose the nearest of the four palette colors for each pixel.
+// Returns the total squared error.
+static float PickIndices(const ColorBlock& p, const float pal[4][3], int index[16])
+{
+#ifdef BLOCK_SSE
+    __m128 total = _mm_setzero_ps();
+    for (int i=0;  i<16;  i+=4) {
+        __m128 r = _mm_loadu_ps(p.r+i), g = _mm_loadu_ps(p.g+i), b = _mm_loadu_ps(p.b+i);
+        __m128 best = _mm_set1_ps(1e30f);
+        __m128i which = _mm_setzero_si128();
+        for (int k=0;  k<4;  k++) {
+            __m128 dr = _mm_sub_ps(r, _mm_set1_ps(pal[k][0]));
+            __m128 dg = _mm_sub_ps(g, _mm_set1_ps(pal[k][1]));
+            __m128 db = _mm_sub_ps(b, _mm_set1_ps(pal[k][2]));
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            which = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)),
+                                 _mm_andnot_si128(closer, which));
+            best = _mm_min_ps(d, best); }
+        _mm_storeu_si128((__m128i*)(index+i), which);
+        total = _mm_add_ps(total, best); }
+    float t[4];
+    _mm_storeu_ps(t, total);
+    return t[0] + t[1] + t[2] + t[3];
+#else
+    float total = 0.0f;
+    for (int i=0;  i<16;  i++) {
+        float best = 1e30f;
+        for (int k=0;  k<4;  k++) {
+            float dr = p.r[i]-pal[k][0], dg = p.g[i]-pal[k][1], db = p.b[i]-pal[k][2];
+            float d = dr*dr + dg*dg + db*db;
+            if (d < best) { best = d;  index[i] = k; } }
+        total += best; }
+    return total;
+#endif
+}
+
+// Indices for endpoints c0 > c1 (swapped here if need be).  Equal
+// endpoints give a solid block with every index 0.
+static float FitEndpoints(const ColorBlock& p, int& c0, int& c1, int index[16])
+{
+    if (c0 < c1) std::swap(c0, c1);
+    float pal[4][3];
+    From565(c0, pal[0]);
+    From565(c1, pal[1]);
+    for (int c=0;  c<3;  c++) {
+        pal[2][c] = (2.0f*pal[0][c] + pal[1][c])/3.0f;
+        pal[3][c] = (pal[0][c] + 2.0f*pal[1][c])/3.0f; }
+    if (c0 == c1)
+        for (int k=1;  k<4;  k++)
+            for (int c=0;  c<3;  c++) pal[k][c] = pal[0][c];
+    return PickIndices(p, pal, index);
+}
+
+static void EncodeBC1(const unsigned char* block, unsigned char out[8])
+{
+    ColorBlock p;
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i=0;  i<16;  i++) {
+        p.r[i] = block[4*i];  p.g[i] = block[4*i+1];  p.b[i] = block[4*i+2];
+        mean[0] += p.r[i];  mean[1] += p.g[i];  mean[2] += p.b[i]; }
+    for (int c=0;  c<3;  c++) mean[c] /= 16.0f;
+
+    // Principal axis of the colors, by power iteration on the covariance
+    float cov[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int i=0;  i<16;  i++) {
+        float r = p.r[i]-mean[0], g = p.g[i]-mean[1], b = p.b[i]-mean[2];
+        cov[0] += r*r;  cov[1] += r*g;  cov[2] += r*b;
+        cov[3] += g*g;  cov[4] += g*b;  cov[5] += b*b; }
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iter=0;  iter<4;  iter++) {
+        float x = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2];
+        float y = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+        float z = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+        float m = std::max(fabsf(x), std::max(fabsf(y), fabsf(z)));
+        if (m == 0.0f) break;
+        axis[0] = x/m;  axis[1] = y/m;  axis[2] = z/m; }
+
+    // Extremes along the axis, inset by 1/16 of the range
+    float lo = 1e30f, hi = -1e30f;
+    for (int i=0;  i<16;  i++) {
+        float t = (p.r[i]-mean[0])*axis[0] + (p.g[i]-mean[1])*axis[1] + (p.b[i]-mean[2])*axis[2];
+        lo = std::min(lo, t);
+        hi = std::max(hi, t); }
+    float len2 = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+    float inset = (hi - lo)/16.0f;
+    float e0[3], e1[3];
+    for (int c=0;  c<3;  c++) {
+        e0[c] = mean[c] + axis[c]*(hi - inset)/len2;
+        e1[c] = mean[c] + axis[c]*(lo + inset)/len2; }
+
+    int c0 = To565(e0[0], e0[1], e0[2]), c1 = To565(e1[0], e1[1], e1[2]);
+    int index[16];
+    float err = FitEndpoints(p, c0, c1, index);
+
+    // Refit:  the endpoints that best reproduce the pixels with these
+    // indices, by least squares, kept if they do better.
+    static const float weight[4] = { 1.0f, 0.0f, 2.0f/3.0f, 1.0f/3.0f };
+    float aa = 0, ab = 0, bb = 0, ap[3] = { 0, 0, 0 }, bp[3] = { 0, 0, 0 };
+    for (int i=0;  i<16;  i++) {
+        float a = weight[index[i]], b = 1.0f - a;
+        aa += a*a;  ab += a*b;  bb += b*b;
+        ap[0] += a*p.r[i];  ap[1] += a*p.g[i];  ap[2] += a*p.b[i];
+        bp[0] += b*p.r[i];  bp[1] += b*p.g[i];  bp[2] += b*p.b[i]; }
+    float det = aa*bb - ab*ab;
+    if (c0 != c1 && fabsf(det) > 1e-6f) {
+        for (int c=0;  c<3;  c++) {
+            e0[c] = (ap[c]*bb - bp[c]*ab)/det;
+            e1[c] = (bp[c]*aa - ap[c]*ab)/det; }
+        int d0 = To565(e0[0], e0[1], e0[2]), d1 = To565(e1[0], e1[1], e1[2]);
+        int refit[16];
+        float err2 = FitEndpoints(p, d0, d1, refit);
+        if (err2 < err) {
+            c0 = d0;  c1 = d1;
+            memcpy(index, refit, sizeof(index)); } }
+
+    uint32_t bits = 0;
+    for (int i=0;  i<16;  i++)
+        bits |= (uint32_t)index[i] << (2*i);
+    out[0] = c0 & 0xff;  out[1] = c0 >> 8;
+    out[2] = c1 & 0xff;  out[3] = c1 >> 8;
+    for (int i=0;  i<4;  i++)
+        out[4+i] = (unsigned char)(bits >> (8*i));
+}
+
+////////////////////////////////////////////////////////////////////////
+// BC6H (unsigned float):  RGB endpoints and a 4 bit index per pixel,
+// over one region, in mode 11 (two 10 bit endpoints) or mode 12 (an
+// 11 bit endpoint and a 9 bit signed difference to the other),
+// whichever reproduces the block better.  Endpoints and palette are
+// in the format's 16 bit unquantized scale U, in which a half float's
+// bits are U*31/64.
+
+static const int hdrWeight[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// The bits of a half float from v >= 0.  Negative values and NaNs
+// become 0, values beyond the largest finite half (65504) that.
+static int FloatToHalf(const float v)
+{
+    if (!(v > 0.0f)) return 0;
+    if (v >= 65504.0f) return 0x7bff;
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    int e = (int)(bits >> 23) - 127 + 15;
+    uint32_t m = bits & 0x7fffff;
+    if (e <= 0) {               // Denormal
+        if (e < -10) return 0;
+        m = (m | 0x800000) >> (1 - e);
+        e = 0; }
+    return std::min(0x7bff, (int)(((uint32_t)e << 10) + ((m + 0x1000) >> 13)));
+}
+
+static float HalfToFloat(const int h)
+{
+    int e = h >> 10, m = h & 1023;
+    if (e == 0) return ldexpf((float)m, -24);                   // Denormal
+    return ldexpf(1.0f + m/1024.0f, e - 15);
+}
+
+// An endpoint of prec bits in the U scale, as the decoder widens it
+static int Unquantize(const int q, const int prec)
+{
+    if (q == 0) return 0;
+    if (q == (1 << prec) - 1) return 0xffff;
+    return ((q << 16) + 0x8000) >> prec;
+}
+
+// The endpoint of prec bits nearest u.  Unquantize is not linear at
+// the ends, so the neighbours are tried too.
+static int Quantize(const float u, const int prec)
+{
+    int top = (1 << prec) - 1;
+    int q = std::min(top, std::max(0, (int)(u*(1 << prec)/65536.0f)));
+    int best = q;
+    float d = 1e30f;
+    for (int k=std::max(0, q-1);  k<=std::min(top, q+1);  k++) {
+        float e = fabsf(Unquantize(k, prec) - u);
+        if (e < d) { d = e;  best = k; } }
+    return best;
+}
+
+// The 16 pixels of a block in the U scale
+struct HdrBlock
+{
+    float u[16][3];
+};
+
+// Choose the nearest of the 16 palette entries between endpoints q
+// (of prec bits) for each pixel.  Returns the total squared error.
+static float PickHdrIndices(const HdrBlock& p, const int prec, const int q[2][3], int index[16])
+{
+    float pal[16][3];
+    for (int c=0;  c<3;  c++) {
+        int a = Unquantize(q[0][c], prec), b = Unquantize(q[1][c], prec);
+        for (int k=0;  k<16;  k++)
+            pal[k][c] = (float)((a*(64 - hdrWeight[k]) + b*hdrWeight[k] + 32) >> 6); }
+
+    float total = 0.0f;
+    for (int i=0;  i<16;  i++) {
+        float best = 1e30f;
+        for (int k=0;  k<16;  k++) {
+            float dr = p.u[i][0]-pal[k][0], dg = p.u[i][1]-pal[k][1], db = p.u[i][2]-pal[k][2];
+            float d = dr*dr + dg*dg + db*db;
+            if (d < best) { best = d;  index[i] = k; } }
+        total += best; }
+    return total;
+}
+
+// Endpoints e (in U) quantized for mode 11 or 12 into q, with their
+// indices.  Pixel 0's index must be below 8 (its top bit is not
+// stored), so the endpoints are swapped if need be;  the palette is
+// symmetric, so nothing else changes.  Returns the squared error, or
+// 1e30 if mode 12's difference does not fit in 9 bits.
+static float FitHdrEndpoints(const HdrBlock& p, const int mode, const float e[2][3],
+                             int q[2][3], int index[16])
+{
+    int prec = mode == 11 ? 10 : 11;
+    for (int k=0;  k<2;  k++)
+        for (int c=0;  c<3;  c++)
+            q[k][c] = Quantize(std::min(std::max(e[k][c], 0.0f), 65535.0f), prec);
+    float err = PickHdrIndices(p, prec, q, index);
+    if (index[0] >= 8) {
+        for (int c=0;  c<3;  c++) std::swap(q[0][c], q[1][c]);
+        for (int i=0;  i<16;  i++) index[i] = 15 - index[i]; }
+    if (mode == 12)
+        for (int c=0;  c<3;  c++)
+            if (q[1][c] - q[0][c] < -256 || q[1][c] - q[0][c] > 255)
+                return 1e30f;
+    return err;
+}
+
+// Append the low n bits of v to out at bit pos.
+static void PutBits(unsigned char* out, int& pos, const int v, const int n)
+{
+    for (int k=0;  k<n;  k++, pos++)
+        if ((v >> k) & 1)
+            out[pos >> 3] |= (unsigned char)(1 << (pos & 7));
+}
+
+static void EncodeBC6H(const float* rgba, unsigned char out[16])
+{
+    HdrBlock p;
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i=0;  i<16;  i++)
+        for (int c=0;  c<3;  c++) {
+            p.u[i][c] = FloatToHalf(rgba[4*i+c])*64.0f/31.0f;
+            mean[c] += p.u[i][c]; }
+    for (int c=0;  c<3;  c++) mean[c] /= 16.0f;
+
+    // Principal axis, as for BC1
+    float cov[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int i=0;  i<16;  i++) {
+        float r = p.u[i][0]-mean[0], g = p.u[i][1]-mean[1], b = p.u[i][2]-mean[2];
+        cov[0] += r*r;  cov[1] += r*g;  cov[2] += r*b;
+        cov[3] += g*g;  cov[4] += g*b;  cov[5] += b*b; }
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iter=0;  iter<4;  iter++) {
+        float x = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2];
+        float y = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+        float z = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+        float m = std::max(fabsf(x), std::max(fabsf(y), fabsf(z)));
+        if (m == 0.0f) break;
+        axis[0] = x/m;  axis[1] = y/m;  axis[2] = z/m; }
+
+    // Extremes along the axis, inset by 1/32 of the range
+    float lo = 1e30f, hi = -1e30f;
+    for (int i=0;  i<16;  i++) {
+        float t = (p.u[i][0]-mean[0])*axis[0] + (p.u[i][1]-mean[1])*axis[1] + (p.u[i][2]-mean[2])*axis[2];
+        lo = std::min(lo, t);
+        hi = std::max(hi, t); }
+    float len2 = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+    float inset = (hi - lo)/32.0f;
+    float e[2][3];
+    for (int c=0;  c<3;  c++) {
+        e[0][c] = mean[c] + axis[c]*(lo + inset)/len2;
+        e[1][c] = mean[c] + axis[c]*(hi - inset)/len2; }
+
+    // Each mode with these endpoints, then with the least squares
+    // refit of the best so far
+    int mode = 11, q[2][3], index[16];
+    float err = FitHdrEndpoints(p, 11, e, q, index);
+    for (int pass=0;  pass<2;  pass++) {
+        if (pass == 1) {
+            float aa = 0, ab = 0, bb = 0, ap[3] = { 0, 0, 0 }, bp[3] = { 0, 0, 0 };
+            for (int i=0;  i<16;  i++) {
+                float b = hdrWeight[index[i]]/64.0f, a = 1.0f - b;
+                aa += a*a;  ab += a*b;  bb += b*b;
+                for (int c=0;  c<3;  c++) {
+                    ap[c] += a*p.u[i][c];
+                    bp[c] += b*p.u[i][c]; } }
+            float det = aa*bb - ab*ab;
+            if (fabsf(det) <= 1e-6f) break;
+            for (int c=0;  c<3;  c++) {
+                e[0][c] = (ap[c]*bb - bp[c]*ab)/det;
+                e[1][c] = (bp[c]*aa - ap[c]*ab)/det; } }
+        for (int m=11;  m<=12;  m++) {
+            if (pass == 0 && m == 11) continue;
+            int q2[2][3], index2[16];
+            float err2 = FitHdrEndpoints(p, m, e, q2, index2);
+            if (err2 < err) {
+                err = err2;
+                mode = m;
+                memcpy(q, q2, sizeof(q));
+                memcpy(index, index2, sizeof(index)); } } }
+
+    memset(out, 0, 16);
+    int pos = 0;
+    if (mode == 11) {
+        PutBits(out, pos, 0x03, 5);
+        for (int k=0;  k<2;  k++)
+            for (int c=0;  c<3;  c++)
+                PutBits(out, pos, q[k][c], 10); }
+    else {
+        PutBits(out, pos, 0x07, 5);
+        for (int c=0;  c<3;  c++)
+            PutBits(out, pos, q[0][c], 10);
+        for (int c=0;  c<3;  c++) {
+            PutBits(out, pos, q[1][c] - q[0][c], 9);
+            PutBits(out, pos, q[0][c] >> 10, 1); } }
+    PutBits(out, pos, index[0], 3);
+    for (int i=1;  i<16;  i++)
+        PutBits(out, pos, index[i], 4);
+}
+
+// Copy block (bx,by) of a w by h float RGBA image into 16 pixels.
+static void GetHdrBlock(const float* rgba, const int w, const int h,
+                        const int bx, const int by, float block[64])
+{
+    for (int y=0;  y<4;  y++) {
+        const float* row = rgba + (size_t)std::min(4*by+y, h-1)*w*4;
+        for (int x=0;  x<4;  x++)
+            memcpy(block + 16*y + 4*x, row + 4*std::min(4*bx+x, w-1), 4*sizeof(float)); }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+static void CompressRows(const BlockFormat format, const unsigned char* rgba, const int w, const int h,
+                         unsigned char* out, const int firstRow, const int lastRow)
+{
+    int bw = (w+3)/4;
+    size_t bytes = format == BLOCK_BC1 ? 8 : 16;
+    unsigned char block[64];
+    for (int by=firstRow;  by<lastRow;  by++)
+        for (int bx=0;  bx<bw;  bx++) {
+            unsigned char* o = out + ((size_t)by*bw + bx)*bytes;
+            GetBlock(rgba, w, h, bx, by, block);
+            switch (format) {
+            case BLOCK_BC1:
+                EncodeBC1(block, o);
+                break;
+            case BLOCK_BC3:
+                EncodeBC4(block+3, o);
+                EncodeBC1(block, o+8);
+                break;
+            case BLOCK_BC5:
+                EncodeBC4(block, o);
+                EncodeBC4(block+1, o+8);
+                break;
+            case BLOCK_BC6H:        // From floats only (CompressBlocksHdr)
+                break; } }
+}
+
+void CompressBlocks(const BlockFormat format, const unsigned char* rgba,
+                    const int w, const int h, unsigned char* out)
+{
+    ShareRows((h+3)/4, [format, rgba, w, h, out](int first, int last) {
+            CompressRows(format, rgba, w, h, out, first, last); });
+}
+
+void CompressBlocksHdr(const float* rgba, const int w, const int h, unsigned char* out)
+{
+    int bw = (w+3)/4;
+    ShareRows((h+3)/4, [rgba, w, h, out, bw](int first, int last) {
+            float block[64];
+            for (int by=first;  by<last;  by++)
+                for (int bx=0;  bx<bw;  bx++) {
+                    GetHdrBlock(rgba, w, h, bx, by, block);
+                    EncodeBC6H(block, out + ((size_t)by*bw + bx)*16); } });
+}
+
+////////////////////////////////////////////////////////////////////////
+// Decoding
+
+// BC4 into every fourth byte of v
+static void DecodeBC4(const unsigned char in[8], unsigned char* v)
+{
+    int pal[8];
+    pal[0] = in[0];
+    pal[1] = in[1];
+    if (pal[0] > pal[1])
+        for (int k=1;  k<7;  k++) pal[k+1] = ((7-k)*pal[0] + k*pal[1])/7;
+    else {
+        for (int k=1;  k<5;  k++) pal[k+1] = ((5-k)*pal[0] + k*pal[1])/5;
+        pal[6] = 0;
+        pal[7] = 255; }
+
+    uint64_t bits = 0;
+    for (int i=0;  i<6;  i++)
+        bits |= (uint64_t)in[2+i] << (8*i);
+    for (int i=0;  i<16;  i++)
+        v[4*i] = (unsigned char)pal[(bits >> (3*i)) & 7];
+}
+
+// BC1 into the RGB of 16 pixels.  Three color mode (c0 <= c1) gives
+// black for index 3;  BC1 is always read as opaque here.
+static void DecodeBC1(const unsigned char in[8], unsigned char* block)
+{
+    int c0 = in[0] | (in[1] << 8), c1 = in[2] | (in[3] << 8);
+    float pal[4][3];
+    From565(c0, pal[0]);
+    From565(c1, pal[1]);
+    for (int c=0;  c<3;  c++)
+        if (c0 > c1) {
+            pal[2][c] = (2.0f*pal[0][c] + pal[1][c])/3.0f;
+            pal[3][c] = (pal[0][c] + 2.0f*pal[1][c])/3.0f; }
+        else {
+            pal[2][c] = (pal[0][c] + pal[1][c])/2.0f;
+            pal[3][c] = 0.0f; }
+
+    uint32_t bits = in[4] | (in[5] << 8) | (in[6] << 16) | ((uint32_t)in[7] << 24);
+    for (int i=0;  i<16;  i++) {
+        const float* p = pal[(bits >> (2*i)) & 3];
+        for (int c=0;  c<3;  c++)
+            block[4*i+c] = (unsigned char)(p[c] + 0.5f); }
+}
+
+void DecompressBlocks(const BlockFormat format, const unsigned char* in,
+                      const int w, const int h, unsigned char* rgba)
+{
+    int bw = (w+3)/4;
+    size_t bytes = format == BLOCK_BC1 ? 8 : 16;
+    unsigned char block[64];
+    for (int by=0;  by<(h+3)/4;  by++)
+        for (int bx=0;  bx<bw;  bx++) {
+            const unsigned char* b = in + ((size_t)by*bw + bx)*bytes;
+            memset(block, 0, sizeof(block));
+            for (int i=0;  i<16;  i++) block[4*i+3] = 255;
+            switch (format) {
+            case BLOCK_BC1:
+                DecodeBC1(b, block);
+                break;
+            case BLOCK_BC3:
+                DecodeBC4(b, block+3);
+                DecodeBC1(b+8, block);
+                break;
+            case BLOCK_BC5:
+                DecodeBC4(b, block);
+                DecodeBC4(b+8, block+1);
+                break;
+            case BLOCK_BC6H:        // To floats only (DecompressBlocksHdr)
+                break; }
+
+            // Partial blocks at the edges keep only the pixels inside.
+            for (int y=0;  y<4 && 4*by+y<h;  y++)
+                for (int x=0;  x<4 && 4*bx+x<w;  x++)
+                    memcpy(rgba + ((size_t)(4*by+y)*w + 4*bx+x)*4, block + 16*y + 4*x, 4); }
+}
+
+// The next n bits of in from bit pos
+static int GetBits(const unsigned char* in, int& pos, const int n)
+{
+    int v = 0;
+    for (int k=0;  k<n;  k++, pos++)
+        v |= ((in[pos >> 3] >> (pos & 7)) & 1) << k;
+    return v;
+}
+
+// BC6H into 16 float RGBA pixels.  Only the one-region modes
+// EncodeBC6H writes, 11 and 12, are read;  a block in any other mode
+// decodes to black.
+static void DecodeBC6H(const unsigned char in[16], float* rgba)
+{
+    int pos = 0, mode = GetBits(in, pos, 5), prec, q[2][3];
+    for (int i=0;  i<16;  i++) {
+        rgba[4*i] = rgba[4*i+1] = rgba[4*i+2] = 0.0f;
+        rgba[4*i+3] = 1.0f; }
+    if (mode == 0x03) {
+        prec = 10;
+        for (int k=0;  k<2;  k++)
+            for (int c=0;  c<3;  c++)
+                q[k][c] = GetBits(in, pos, 10); }
+    else if (mode == 0x07) {
+        prec = 11;
+        for (int c=0;  c<3;  c++)
+            q[0][c] = GetBits(in, pos, 10);
+        for (int c=0;  c<3;  c++) {
+            int d = GetBits(in, pos, 9);
+            q[0][c] |= GetBits(in, pos, 1) << 10;
+            if (d & 256) d -= 512;
+            q[1][c] = (q[0][c] + d) & 2047; } }
+    else
+        return;
+
+    for (int i=0;  i<16;  i++) {
+        int w = hdrWeight[GetBits(in, pos, i == 0 ? 3 : 4)];
+        for (int c=0;  c<3;  c++) {
+            int u = (Unquantize(q[0][c], prec)*(64 - w) + Unquantize(q[1][c], prec)*w + 32) >> 6;
+            rgba[4*i+c] = HalfToFloat((u*31) >> 6); } }
+}
+
+void DecompressBlocksHdr(const unsigned char* in, const int w, const int h, float* rgba)
+{
+    int bw = (w+3)/4;
+    float block[64];
+    for (int by=0;  by<(h+3)/4;  by++)
+        for (int bx=0;  bx<bw;  bx++) {
+            DecodeBC6H(in + ((size_t)by*bw + bx)*16, block);
+            for (int y=0;  y<4 && 4*by+y<h;  y++)
+                for (int x=0;  x<4 && 4*bx+x<w;  x++)
+                    memcpy(rgba + ((size_t)(4*by+y)*w + 4*bx+x)*4, block + 16*y + 4*x, 4*sizeof(float)); }
+}
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////
+// A CPU encoder and decoder for the BCn block-compressed texture formats.  Each 4x4
+// block of pixels becomes 8 bytes (BC1) or 16 bytes (BC3, BC5, BC6H):
+//
+//   BC1  RGB, 4 bits per pixel          GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+//   BC3  RGBA, 8 bits per pixel         GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+//   BC5  two channels (RG), 8 bits/pix  GL_COMPRESSED_RG_RGTC2
+//   BC6H HDR RGB, 8 bits per pixel      GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+//
+// BC5 keeps only the x and y of a normal map;  shaders rebuild z.
+// BC6H takes float images (CompressBlocksHdr), and holds nonnegative
+// values up to 65504 as half floats;  this encoder writes one-region
+// blocks only (modes 11 and 12), and its decoder reads only those.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _BLOCKCOMPRESS_
+#define _BLOCKCOMPRESS_
+
+#include <stddef.h>
+
+enum BlockFormat { BLOCK_BC1, BLOCK_BC3, BLOCK_BC5, BLOCK_BC6H };
+
+// Bytes needed for a w by h image
+size_t BlockSize(const BlockFormat format, const int w, const int h);
+
+// Compress a w by h RGBA8 image into out (BlockSize bytes) as BC1, BC3
+// or BC5, in rows of blocks in the same order as the image rows.  Partial blocks at the
+// right and top edges repeat the edge pixels.  Rows of blocks are
+// shared out among the hardware threads.
+void CompressBlocks(const BlockFormat format, const unsigned char* rgba,
+                    const int w, const int h, unsigned char* out);
+
+// Decompress a w by h image (BlockSize bytes) into w*h RGBA8 pixels,
+// as a GL implementation would read it:  BC1 has alpha 255, and BC5
+// has blue 0 and alpha 255.
+void DecompressBlocks(const BlockFormat format, const unsigned char* in,
+                      const int w, const int h, unsigned char* rgba);
+
+// The same for BC6H, from and to float RGBA (alpha ignored, and
+// decoded as 1).
+void CompressBlocksHdr(const float* rgba, const int w, const int h, unsigned char* out);
+void DecompressBlocksHdr(const unsigned char* in, const int w, const int h, float* rgba);
+
+#endif
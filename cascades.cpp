@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////
+// Cascaded shadow map fitting (see cascades.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <algorithm>
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "transform.h"
+#include "cascades.h"
+
+ShadowCascades::ShadowCascades()
+    : count(1), size(2048), lambda(0.75f), distance(400.0f), casterMargin(100.0f)
+{
+    for (int i=0;  i<MaxCascades;  i++)
+        resolution[i] = size;
+}
+
+void ShadowCascades::Fit(const glm::mat4& WorldView, const glm::mat4& WorldProj, const glm::vec3& toLight)
+{
+    // The rays through the corners of the view, at unit depth, and the
+    // depth of the near plane
+    glm::mat4 ProjInverse = glm::inverse(WorldProj);
+    glm::mat4 ViewInverse = glm::inverse(WorldView);
+    glm::vec3 ray[4];
+    float front = 0.0f;
+    for (int k=0;  k<4;  k++) {
+        glm::vec4 p = ProjInverse*glm::vec4(k&1 ? 1.0f : -1.0f, k&2 ? 1.0f : -1.0f, -1.0f, 1.0f);
+        front = -p.z/p.w;
+        ray[k] = glm::vec3(p)/(-p.z); }
+
+    float back = std::max(distance, 2.0f*front);
+    for (int i=0;  i<=count;  i++) {
+        float f = (float)i/count;
+        split[i] = lambda*front*powf(back/front, f) + (1.0f-lambda)*(front + (back-front)*f); }
+
+    // The light's axes;  only translation changes from cascade to cascade.
+    glm::vec3 L = glm::normalize(toLight);
+    glm::vec3 up = fabsf(L.z) < 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+    glm::mat4 R = LookAt(glm::vec3(0.0f), -L, up);
+
+    for (int i=0;  i<count;  i++) {
+        glm::vec3 corner[8];
+        glm::vec3 center(0.0f);
+        for (int k=0;  k<8;  k++) {
+            corner[k] = glm::vec3(ViewInverse*glm::vec4(ray[k&3]*split[i + (k>>2)], 1.0f));
+            center += corner[k]/8.0f; }
+        float r = 0.0f;
+        for (int k=0;  k<8;  k++)
+            r = std::max(r, glm::length(corner[k] - center));
+        // A texel wider, for the snapping below;  rounded up so the
+        // size does not flicker with rounding error.
+        r = ceilf(r*(1.0f + 2.0f/resolution[i])*16.0f)/16.0f;
+
+        // Snap the center, across the light, to whole texels.
+        glm::vec3 c = glm::vec3(R*glm::vec4(center, 1.0f));
+        texel[i] = 2.0f*r/resolution[i];
+        c.x = floorf(c.x/texel[i])*texel[i];
+        c.y = floorf(c.y/texel[i])*texel[i];
+
+        View[i] = Translate(-c.x, -c.y, 0.0f)*R;
+        depthRange[i] = 2.0f*r + casterMargin;
+        Proj[i] = Orthographic(r, r, -c.z - r - casterMargin, -c.z + r);
+
+        float s = (float)resolution[i]/size;
+        Matrix[i] = Translate(s/2, s/2, 0.5f)*Scale(s/2, s/2, 0.5f)*Proj[i]*View[i]; }
+}
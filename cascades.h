@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////
+// Cascaded shadow maps:  the view frustum, out to a shadow distance,
+// is split along its depth into a few cascades, each covered by its
+// own orthographic light projection and shadow map layer.  Near the
+// eye a texel covers little, far away much, so the shadow map's
+// resolution goes where the view needs it.
+//
+// The splits blend logarithmic spacing (equal ratios of far to near)
+// with uniform spacing.  Each cascade's projection is fitted to the
+// bounding sphere of its piece of the frustum, so its size does not
+// change as the camera turns, and its position is snapped to whole
+// texels, so shadow edges do not shimmer as the camera moves.
+//
+// The cascades are layers of one texture array.  A cascade may use
+// less than a whole layer (resolution[i] of size texels a side);  its
+// Matrix maps world points into that corner of the layer.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _CASCADES_
+#define _CASCADES_
+
+// As many as the shaders take (cascadeFar[] in multilight.frag)
+const int MaxCascades = 4;
+
+class ShadowCascades
+{
+ public:
+    int count;
+    int size;                           // Texels on a side of each layer
+    int resolution[MaxCascades];        // Texels on a side used of each layer
+    float lambda;                       // 1 for logarithmic splits, 0 for uniform
+    float distance;                     // Shadows end this far from the eye
+    float casterMargin;                 // Depth kept toward the light for casters out of view
+
+    // Filled by Fit
+    float split[MaxCascades+1];         // View depths bounding the cascades
+    glm::mat4 View[MaxCascades];        // For the shadow pass
+    glm::mat4 Proj[MaxCascades];
+    glm::mat4 Matrix[MaxCascades];      // World to (u, v, depth in [0,1]) in the layer
+    float texel[MaxCascades];           // World units across a texel
+    float depthRange[MaxCascades];      // World units from depth 0 to 1
+
+    ShadowCascades();
+
+    // Fit the cascades to the view given by WorldView and WorldProj,
+    // for a light in the direction toLight.
+    void Fit(const glm::mat4& WorldView, const glm::mat4& WorldProj, const glm::vec3& toLight);
+};
+
+#endif
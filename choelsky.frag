@@ -97,7 +97,7 @@ void main()
     if(z2 > z3){
         float tmp = z2;
         z2 = z3;
-        z3 = z2;
+        z3 = tmp;
     }
 
     float Gs = 0.0;
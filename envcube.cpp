@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////
+// Equirectangular images resampled into cube maps (see envcube.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <algorithm>
+#include <thread>
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "envcube.h"
+#include "texsampler.h"
+
+// Rows of a face sampled per call to TexSampler::Sample
+static const int batchRows = 4;
+
+// The direction through face coordinates (s,t), each in [-1,1], of
+// face f, as the GL_TEXTURE_CUBE_MAP lookup defines them:  t grows
+// with the face's rows.
+static glm::vec3 FaceDirection(const int f, const float s, const float t)
+{
+    switch (f) {
+    case 0: return glm::vec3( 1.0f,    -t,    -s);     // +X
+    case 1: return glm::vec3(-1.0f,    -t,     s);     // -X
+    case 2: return glm::vec3(    s,  1.0f,     t);     // +Y
+    case 3: return glm::vec3(    s, -1.0f,    -t);     // -Y
+    case 4: return glm::vec3(    s,    -t,  1.0f);     // +Z
+    default: return glm::vec3(  -s,    -t, -1.0f); }   // -Z
+}
+
+// Fill face f of every level.  A level-i texel spans about 2/n radians
+// (n its face size), and a source texel 2 pi/width, so the source is
+// read at the lod where the two match.
+static void FillFace(const TexSampler& src, const int f, const int size, const int levels,
+                     const size_t* offset, uint32_t* texels)
+{
+    const float pi = 3.14159265f;
+    std::vector<glm::vec2> uv;
+    std::vector<glm::vec4> rgb;
+    for (int i=0;  i<levels;  i++) {
+        int n = std::max(1, size >> i);
+        float lod = std::max(0.0f, log2f(src.width/(pi*n)));
+        uint32_t* dst = texels + offset[i] + (size_t)f*n*n;
+        for (int y0=0;  y0<n;  y0+=batchRows) {
+            int rows = std::min(batchRows, n-y0);
+            uv.resize((size_t)rows*n);
+            rgb.resize(uv.size());
+            for (int y=0;  y<rows;  y++) {
+                float t = 2.0f*(y0 + y + 0.5f)/n - 1.0f;
+                for (int x=0;  x<n;  x++) {
+                    float s = 2.0f*(x + 0.5f)/n - 1.0f;
+                    glm::vec3 D = glm::normalize(FaceDirection(f, s, t));
+                    uv[y*n + x] = glm::vec2(0.5f - atan2f(D.y, D.x)/(2.0f*pi),
+                                            acosf(glm::clamp(D.z, -1.0f, 1.0f))/pi); } }
+            src.Sample(&uv[0], &rgb[0], (int)uv.size(), lod);
+            for (size_t k=0;  k<rgb.size();  k++)
+                dst[(size_t)y0*n + k] = PackRgb9e5(rgb[k].x, rgb[k].y, rgb[k].z); } }
+}
+
+bool EnvCube::Load(const std::string& path)
+{
+    MipChain chain;
+    if (!chain.Load(path)) {
+        reason = chain.reason;
+        return false; }
+
+    // Around the equator, the image's width covers four faces.
+    TexSampler src(chain, WRAP_REPEAT, FILTER_TRILINEAR);
+    src.wrapV = WRAP_CLAMP;
+    size = std::max(1, chain.width/4);
+
+    size_t total = 0;
+    for (levels=0;  levels<MaxMipLevels;  ) {
+        offset[levels] = total;
+        int n = LevelSize(levels);
+        total += (size_t)6*n*n;
+        levels++;
+        if (n == 1) break; }
+    texels.assign(total, 0);
+
+    std::thread faces[6];
+    for (int f=0;  f<6;  f++)
+        faces[f] = std::thread(FillFace, std::cref(src), f, size, levels, offset, &texels[0]);
+    for (int f=0;  f<6;  f++)
+        faces[f].join();
+    return true;
+}
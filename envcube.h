@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////
+// An environment map resampled from an equirectangular image into a
+// mipmapped cube map, so shaders look it up with a direction vector
+// instead of atan and acos, without the seam at the wrap-around or
+// the pinching at the poles.
+//
+// A direction D maps to the image as
+//    u = 0.5 - atan(D.y, D.x)/(2 pi),   v = acos(D.z)/pi
+// Each level is sampled straight from the image (through a TexSampler,
+// with a trilinear lod matching the level's texel size), so the faces
+// of every level meet without seams.  Texels are RGB9_E5, which holds
+// high dynamic range skies at 4 bytes a texel.  The six faces are
+// filled in parallel.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _ENVCUBE_
+#define _ENVCUBE_
+
+#include <string>
+#include <vector>
+
+#include "mipchain.h"
+
+class EnvCube
+{
+ public:
+    int size;                   // Of a level 0 face
+    int levels;
+    const char* reason;         // Why Load failed
+
+    EnvCube() : size(0), levels(0), reason(NULL) {}
+
+    // Resample an equirectangular image file (as read by MipChain, so
+    // the source's mipmaps are cached on disk).  Returns false if the
+    // source cannot be read.
+    bool Load(const std::string& path);
+
+    int LevelSize(const int i) const { return size >> i ? size >> i : 1; }
+
+    // Texels of face f (in GL_TEXTURE_CUBE_MAP_POSITIVE_X order) of
+    // level i, first row first.
+    const uint32_t* Face(const int i, const int f) const { return &texels[offset[i] + (size_t)f*LevelSize(i)*LevelSize(i)]; }
+
+    size_t Bytes() const { return texels.size()*sizeof(uint32_t); }
+
+ private:
+    std::vector<uint32_t> texels;
+    size_t offset[MaxMipLevels];        // Of each level's six faces
+};
+
+#endif
@@ -6,15 +6,20 @@
 // texture.
 ////////////////////////////////////////////////////////////////////////
 
+#include <stdio.h>
+#include <algorithm>
+
 #include <glbinding/gl/gl.h>
 #include <glbinding/Binding.h>
 using namespace gl;
 
 #include "fbo.h"
 
-void FBO::CreateFBO(const int w, const int h, bool isGBuffer)
+void FBO::CreateFBO(const int w, const int h, bool isGBuffer, const GLenum format)
 {
     this->isGBuffer = isGBuffer;
+    this->format = (unsigned int)format;
+    layers = 0;
     width = w;
     height = h;
 
@@ -31,12 +36,11 @@ void FBO::CreateFBO(const int w, const int h, bool isGBuffer)
                                  GL_RENDERBUFFER_EXT, depthBuffer);
 
     // Create a texture and attach FBO's color 0 attachment.  The
-    // GL_RGBA32F and GL_RGBA constants set this texture to be 32 bit
-    // floats for each of the 4 components.  Many other choices are
-    // possible.
+    // default GL_RGBA32F sets this texture to be 32 bit floats for
+    // each of the 4 components.  Many other choices are possible.
     glGenTextures(1, &textureID[0]);
     glBindTexture(GL_TEXTURE_2D, textureID[0]);
-    glTexImage2D(GL_TEXTURE_2D, 0, (int)GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, (int)format, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (int)GL_CLAMP_TO_EDGE);
@@ -54,7 +58,7 @@ void FBO::CreateFBO(const int w, const int h, bool isGBuffer)
         glGenTextures(1, &textureID[1]);
 
         glBindTexture(GL_TEXTURE_2D, textureID[1]);
-        glTexImage2D(GL_TEXTURE_2D, 0, (int)GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexImage2D(GL_TEXTURE_2D, 0, (int)format, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (int)GL_CLAMP_TO_EDGE);
@@ -70,7 +74,7 @@ void FBO::CreateFBO(const int w, const int h, bool isGBuffer)
         glGenTextures(1, &textureID[2]);
 
         glBindTexture(GL_TEXTURE_2D, textureID[2]);
-        glTexImage2D(GL_TEXTURE_2D, 0, (int)GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexImage2D(GL_TEXTURE_2D, 0, (int)format, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (int)GL_CLAMP_TO_EDGE);
@@ -86,7 +90,7 @@ void FBO::CreateFBO(const int w, const int h, bool isGBuffer)
         glGenTextures(1, &textureID[3]);
 
         glBindTexture(GL_TEXTURE_2D, textureID[3]);
-        glTexImage2D(GL_TEXTURE_2D, 0, (int)GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexImage2D(GL_TEXTURE_2D, 0, (int)format, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (int)GL_CLAMP_TO_EDGE);
@@ -109,5 +113,72 @@ void FBO::CreateFBO(const int w, const int h, bool isGBuffer)
 }
 
 
+void FBO::CreateArrayFBO(const int w, const int h, const int _layers, const GLenum format)
+{
+    isGBuffer = false;
+    this->format = (unsigned int)format;
+    layers = _layers;
+    width = w;
+    height = h;
+    bool depthOnly = format == GL_DEPTH_COMPONENT32F;
+
+    glGenFramebuffersEXT(1, &fboID);
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fboID);
+
+    // One depth buffer, shared by the layers in turn, unless the
+    // layers are depth themselves.
+    depthBuffer = 0;
+    if (!depthOnly) {
+        glGenRenderbuffersEXT(1, &depthBuffer);
+        glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, depthBuffer);
+        glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT,
+                                 width, height);
+        glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT,
+                                     GL_RENDERBUFFER_EXT, depthBuffer); }
+
+    glGenTextures(1, &textureID[0]);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID[0]);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, format, width, height, layers);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, (int)GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, (int)GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, (int)(depthOnly ? GL_NEAREST : GL_LINEAR));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, (int)(depthOnly ? GL_NEAREST : GL_LINEAR));
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    if (depthOnly) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureID[0], 0, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE); }
+    else
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureID[0], 0, 0);
+
+    int status = (int)glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+    if (status != int(GL_FRAMEBUFFER_COMPLETE_EXT))
+        printf("FBO Error: %d\n", status);
+
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+}
+
+size_t FBO::Bytes() const
+{
+    size_t texel = 16;
+    if (format == (unsigned int)GL_RGBA16 || format == (unsigned int)GL_RGBA16F)
+        texel = 8;
+    else if (format == (unsigned int)GL_RGBA8 || format == (unsigned int)GL_DEPTH_COMPONENT32F)
+        texel = 4;
+    size_t depth = depthBuffer ? 4 : 0;
+    return (size_t)width*height*((isGBuffer ? 4 : std::max(1, layers))*texel + depth);
+}
+
 void FBO::Bind() { glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fboID); }
+void FBO::BindLayer(const int layer)
+{
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fboID);
+    if (format == (unsigned int)GL_DEPTH_COMPONENT32F)
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureID[0], 0, layer);
+    else
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureID[0], 0, layer);
+}
+
 void FBO::Unbind() { glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0); }
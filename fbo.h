@@ -6,6 +6,9 @@
 // texture.
 ////////////////////////////////////////////////////////////////////////
 
+#ifndef _FBO_
+#define _FBO_
+
 class FBO {
 public:
     unsigned int fboID;
@@ -13,8 +16,22 @@ public:
     int width, height;  // Size of the texture.
     bool isGBuffer = false;
     unsigned int depthBuffer;
+    unsigned int format;        // Internal format of the textures
+    int layers;                 // Of a texture array (CreateArrayFBO), else 0
+
+    void CreateFBO(const int w, const int h, bool isGBuffer, const GLenum format=GL_RGBA32F);
 
-    void CreateFBO(const int w, const int h, bool isGBuffer);
+    // One GL_TEXTURE_2D_ARRAY of the given layers, rendered into one
+    // layer at a time (BindLayer), with one depth buffer shared by the
+    // layers.  With format GL_DEPTH_COMPONENT32F, the layers are the
+    // depth buffer, and nothing else is written.
+    void CreateArrayFBO(const int w, const int h, const int layers, const GLenum format);
+
+    // Of the textures and depth buffer, as stored on the card
+    size_t Bytes() const;
     void Bind();
+    void BindLayer(const int layer);
     void Unbind();
 };
+
+#endif
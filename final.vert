@@ -6,12 +6,11 @@
 #version 330
 
 uniform mat4 WorldView, WorldInverse, WorldProj, ModelTr, NormalTr;
-uniform bool reflective;
 
 in vec4 vertex;
 in vec3 vertexNormal;
 in vec2 vertexTexture;
-in vec3 vertexTangent;
+in vec4 vertexTangent;
 
 out vec3 normalVec, lightVec, eyeVec;
 out vec2 texCoord;
@@ -1,46 +1,107 @@
 /////////////////////////////////////////////////////////////////////////
 // Pixel shader for lighting
 ////////////////////////////////////////////////////////////////////////
-#version 330
-
-out vec4 FragColor;
-
-// These definitions agree with the ObjectIds enum in scene.h
-const int     nullId	= 0;
-const int     skyId	= 1;
-const int     seaId	= 2;
-const int     groundId	= 3;
-const int     roomId	= 4;
-const int     boxId	= 5;
-const int     frameId	= 6;
-const int     lPicId	= 7;
-const int     rPicId	= 8;
-const int     teapotId	= 9;
-const int     spheresId	= 10;
-const int     floorId	= 11;
-
-in vec3 normalVec, lightVec, eyeVec, tanVec;
+#version 430
+
+// G-buffer outputs, in the order of GBufferFBO's attachments
+layout(location = 0) out vec4 worldPosOut;
+layout(location = 1) out vec4 normalOut;
+layout(location = 2) out vec4 KdOut;
+layout(location = 3) out vec4 KsOut;
+
+// The material table (see materialtable.h), indexed by material
+const int MAT_SKY_REFLECT = 2;
+const int OBJ_NO_SHADOW = 256;  // Added to the flags for the lighting pass (see object.h)
+
+struct Material
+{
+    vec4 diffuse;               // Kd
+    vec4 specular;              // Ks, and shininess in w
+    vec4 tint;                  // Albedo map tint, and normal map strength in w
+    vec4 uvTransform;           // Columns of a 2x2 matrix
+    vec4 uvScroll;
+    ivec4 maps;                 // Albedo array and layer, normal array and layer;  -1 for none
+    ivec4 flags;
+};
+
+layout(std430, binding = 0) readonly buffer MaterialTable
+{
+    Material materials[];
+};
+
+uniform sampler2DArray materialMaps[8];     // MaxMaterialArrays
+
+in vec3 normalVec, lightVec, eyeVec;
+
+// Tangent, with the bitangent sign in w.  The normal maps here have
+// green pointing down, hence B = w*cross(T,N) rather than w*cross(N,T).
+in vec4 tanVec;
 in vec2 texCoord;
-in vec4 shadowCoord;
 in vec3 worldPos;
 
-uniform int objectId;
-uniform vec3 diffuse;    // Kd
-uniform vec3 specular;   // Ks
-uniform float shininess; // alpha exponent
+uniform int material;
+uniform bool receivesShadow;
 uniform float time;
 
 uniform vec3 Light;    // Ii
 uniform vec3 Ambient;  // Ia
 
 uniform int mode;
-uniform mat4 shadowMatrix;
-uniform sampler2D shadowMap, upperReflect, lowerReflect;
-uniform sampler2D skyTex, skyTex2, groundTex, wallTex, floorTex, teapotTex, frameTex, lFrameTex, rFrameTex;
-uniform sampler2D wallNormal, floorNormal, frameNormal, seaNormal;
+uniform mat4 WorldView;
+uniform sampler2DArray shadowMap;
+uniform sampler2D upperReflect, lowerReflect;
+uniform samplerCube skyTex;
+
+
+// The sky maps hold linear radiance, as cube maps looked up by
+// direction.  Where the sky is shown as a color, encode it for display
+// as stb_image's 8 bit decode used to.
+vec3 SkyColor(samplerCube sky, vec3 D)
+{
+    return pow(max(texture(sky, D).xyz, vec3(0.0)), vec3(1.0/2.2));
+}
+
+// The shadow cascades (see cascades.h):  cascade i covers view depths
+// up to cascadeFar[i], and CascadeMatrix[i] takes a world point to
+// (u, v, depth) in layer i, whose first cascadeExtent[i] of u and v
+// it uses.
+uniform int cascades;
+uniform float cascadeFar[4];
+uniform float cascadeExtent[4];
+uniform mat4 CascadeMatrix[4];
+
+// The cascade covering world point P, and P's coordinates in it;  -1
+// beyond the last.
+int Cascade(vec3 P, out vec3 coord)
+{
+    coord = vec3(0.0);
+    float d = -(WorldView*vec4(P, 1.0)).z;
+    for (int i=0;  i<cascades;  i++)
+        if (d <= cascadeFar[i]) {
+            coord = (CascadeMatrix[i]*vec4(P, 1.0)).xyz;
+            float margin = 0.5/float(textureSize(shadowMap, 0).x);
+            coord.xy = clamp(coord.xy, vec2(margin), vec2(cascadeExtent[i] - margin));
+            return i; }
+    return -1;
+}
 
-uniform bool reflective;
+// Normal maps are stored as BC5, which keeps only x and y;  z is
+// rebuilt from the unit length.  strength scales the tilt.
+vec3 NormalMap(int map, int layer, vec2 uv, float strength)
+{
+    vec3 delta;
+    delta.xy = texture(materialMaps[map], vec3(uv, layer)).xy*2.0 - vec2(1,1);
+    delta.z = sqrt(max(0.0, 1.0 - dot(delta.xy, delta.xy)));
+    delta.xy *= strength;
+    return normalize(delta);
+}
 
+// Equirectangular coordinates of direction D, for maps that ripple
+// with the reflection (MAT_SKY_REFLECT)
+vec2 SkyUV(vec3 D)
+{
+    return vec2(-atan(D.y/D.x)/(3.14159), acos(D.z)/3.14159);
+}
 
 void main()
 {
@@ -49,109 +110,53 @@ void main()
     vec3 V = normalize(eyeVec);
     vec3 H = normalize(L+V);
 
-    vec3 Kd = diffuse;   
+    // Everything object specific comes from the material.  It is the
+    // same for the whole draw, so the branches below never diverge.
+    Material m = materials[material];
+    vec3 Kd = m.diffuse.xyz;
+    vec3 specular = m.specular.xyz;
+    float shininess = m.specular.w;
     float a = shininess;
     
-    vec2 shadowIndex = shadowCoord.xy/shadowCoord.w;
+    vec3 shadowCoord = vec3(0.0);
+    int layer = receivesShadow ? Cascade(worldPos, shadowCoord) : -1;
     
     bool inShadow = false;
     
-    if(shadowCoord.w > 0.0 && shadowIndex.x >= 0.0 && shadowIndex.x <= 1.0 && shadowIndex.y >= 0.0 && shadowIndex.y <= 1.0){
-        if(shadowCoord.w > texture2D(shadowMap, shadowIndex).w + 0.01){
+    if(layer >= 0){
+        if(shadowCoord.z > texture(shadowMap, vec3(shadowCoord.xy, layer)).r + 0.0005){
             inShadow = true;
         }
     }
 
     
-    if(objectId == groundId) {
-        Kd = texture(groundTex, texCoord * 100.0).xyz;
-    }
-    else if(objectId == seaId) {
+    vec2 uv = texCoord;
+    if ((m.flags.x & MAT_SKY_REFLECT) != 0) {
         vec3 R = -(2*dot(V,N) * N - V);
-        vec2 uv = vec2(-atan(R.y/R.x)/(3.14159), acos(R.z)/3.14159);
-        Kd = texture(skyTex, uv).xyz;
-
-        uv.x -= time * 0.001;
-        uv.y += time * 0.001;
-        vec3 delta = texture(seaNormal, uv * 10.0).xyz;
-        delta = delta*2.0 - vec3(1,1,1);
-        vec3 T = normalize(tanVec);
-        vec3 B = normalize(cross(T,N));
-        N = delta.x*T + delta.y*B + delta.z*N;
-    }
-    else if(objectId == roomId) {
-        vec2 uv = vec2(texCoord.y, -texCoord.x);
-        Kd = texture(wallTex, uv * 20.0).xyz * 0.9;
-        
-        vec3 delta = texture(wallNormal, uv * 20.0).xyz;
-        delta = delta*2.0 - vec3(1,1,1);
-        vec3 T = normalize(tanVec);
-        vec3 B = normalize(cross(T,N));
-        N = delta.x*T + delta.y*B + delta.z*N;
-    }
-    else if(objectId == floorId) {
-        Kd = texture(floorTex, texCoord * 4.0).xyz;
+        uv = SkyUV(R);
+        Kd = SkyColor(skyTex, R); }
+    uv = mat2(m.uvTransform) * (uv + time*m.uvScroll.xy);
 
-        
-        vec3 delta = texture(floorNormal, texCoord * 4.0).xyz;
-        delta = delta*2.0 - vec3(1,1,1);
-        vec3 T = normalize(tanVec);
-        vec3 B = normalize(cross(T,N));
-        N = delta.x*T + delta.y*B + delta.z*N;
-        
-    }
-    else if(objectId == teapotId) {
-        Kd = texture(teapotTex, texCoord * 8.0).xyz;
-    }
-    else if(objectId == boxId) {
-        Kd = texture(frameTex, texCoord * 1.0).xyz;
-
-        vec3 delta = texture(frameNormal, texCoord * 1.0).xyz;
-        delta = delta*2.0 - vec3(1,1,1);
-        vec3 T = normalize(tanVec);
-        vec3 B = normalize(cross(T,N));
-        N = delta.x*T + delta.y*B + delta.z*N;
-    }
-    else if(objectId == frameId) {
-        Kd = texture(frameTex, texCoord * 1.0).xyz;
-        
-        vec3 delta = texture(frameNormal, texCoord * 1.0).xyz;
-        delta = delta*2.0 - vec3(1,1,1);
-        vec3 T = normalize(tanVec);
-        vec3 B = normalize(cross(T,N));
-        N = delta.x*T + delta.y*B + delta.z*N;
-        
-    }
-    else if(objectId == lPicId) {
-        Kd = texture(lFrameTex, texCoord * 1.0).xyz;
-    }
-    else if(objectId == rPicId) {
-        Kd = texture(rFrameTex, texCoord * 1.0).xyz;
-    }
-    
+    if (m.maps.x >= 0)
+        Kd = texture(materialMaps[m.maps.x], vec3(uv, m.maps.y)).xyz * m.tint.xyz;
+
+    if (m.maps.z >= 0) {
+        vec3 delta = NormalMap(m.maps.z, m.maps.w, uv, m.tint.w);
+        vec3 T = normalize(tanVec.xyz);
+        vec3 B = tanVec.w*normalize(cross(T,N));
+        N = delta.x*T + delta.y*B + delta.z*N; }
 
     float LN = max(dot(L,N), 0.0);
     float HN = max(dot(H,N), 0.0);
     float HL = max(dot(H,L), 0.0);
 
     
-    if (objectId == skyId) {
-        vec2 uv = vec2(-atan(V.y/V.x)/(3.14159), acos(V.z)/3.14159);
-        Kd.xyz = texture(skyTex, uv).xyz;
-        if(mode == 2){
-            Kd.xyz = texture(skyTex2, uv).xyz;
-        }
-        a = -1;
-    }
-    else if(mode >=7) {        // BRDF lighting
+    if(mode >=7) {        // BRDF lighting
         if(inShadow){
             Kd.xyz = Ambient*Kd;
         }
         else{
             vec3 F = specular + ((1,1,1) - specular) * pow(1 - HL, 5);
-            if(reflective){
-            
-            }
             float G = 1 / pow(HL, 2);
             float D = ((shininess + 2)/6.28318) * pow(HN, shininess);
             Kd.xyz = Ambient*Kd + Light * LN * (Kd/3.14159 + ((F*G*D)/4));
@@ -161,12 +166,10 @@ void main()
     
     
     
-    gl_FragData[0].xyz = worldPos;
-    gl_FragData[1].xyz = N;
-    gl_FragData[2].xyz = Kd;
-    gl_FragData[3].xyz = specular;
-    gl_FragData[3].w = a;
-    
-
-    // FragColor.xyz = vec3(1.0, 0.0, 0.0);
+    worldPosOut.xyz = worldPos;
+    normalOut.xyz = N;
+    KdOut.xyz = Kd;
+    KdOut.w = float(m.flags.x | (receivesShadow ? 0 : OBJ_NO_SHADOW));     // For the lighting pass
+    KsOut.xyz = specular;
+    KsOut.w = a;
 }
@@ -6,28 +6,24 @@
 #version 330
 
 uniform mat4 WorldView, WorldInverse, WorldProj, ModelTr, NormalTr;
-uniform bool reflective;
 
 in vec4 vertex;
 in vec3 vertexNormal;
 in vec2 vertexTexture;
-in vec3 vertexTangent;
+in vec4 vertexTangent;
 
-out vec3 normalVec, lightVec, eyeVec, tanVec;
+out vec3 normalVec, lightVec, eyeVec;
+out vec4 tanVec;
 out vec2 texCoord;
-out vec4 shadowCoord;
 out vec3 worldPos;
 
 uniform vec3 lightPos;
 // uniform int mode;
-uniform mat4 ShadowMatrix;
 
 void main()
 {
     gl_Position = WorldProj*WorldView*ModelTr*vertex;
 
-    shadowCoord = ShadowMatrix*ModelTr*vertex;
-    
     worldPos = (ModelTr*vertex).xyz;
 
     normalVec = vertexNormal*mat3(NormalTr); 
@@ -38,7 +34,7 @@ void main()
     vec3 eyePos = (WorldInverse*vec4(0.0, 0.0, 0.0, 1.0)).xyz;
     eyeVec = eyePos - worldPos;
 
-    tanVec = mat3(ModelTr)*vertexTangent;
+    tanVec = vec4(mat3(ModelTr)*vertexTangent.xyz, vertexTangent.w);
 
     
 }
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////
+// GPU timings (see gputimers.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+
+#include <glbinding/gl/gl.h>
+#include <glbinding/Binding.h>
+using namespace gl;
+
+#include "gputimers.h"
+
+GpuTimers::GpuTimers() : current(NULL)
+{}
+
+GpuTimers::~GpuTimers()
+{
+    for (std::map<std::string, Timer>::iterator t=timers.begin();  t!=timers.end();  t++)
+        glDeleteQueries(2, t->second.query);
+}
+
+// Add query i's time, if it has one ready.
+void GpuTimers::Collect(Timer& t, const int i)
+{
+    if (!t.pending[i]) return;
+    int available = 0;
+    glGetQueryObjectiv(t.query[i], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;
+    GLuint64 ns;
+    glGetQueryObjectui64v(t.query[i], GL_QUERY_RESULT, &ns);
+    t.ms += ns/1.0e6;
+    t.samples++;
+    t.pending[i] = false;
+}
+
+void GpuTimers::Begin(const char* name)
+{
+    std::map<std::string, Timer>::iterator it = timers.find(name);
+    if (it == timers.end()) {
+        Timer t = { {0, 0}, {false, false}, 0, 0.0, 0 };
+        glGenQueries(2, t.query);
+        it = timers.insert(std::make_pair(std::string(name), t)).first; }
+
+    // With both queries still in flight, this run goes untimed rather
+    // than wait.
+    Timer& t = it->second;
+    Collect(t, t.next);
+    current = t.pending[t.next] ? NULL : &t;
+    if (current)
+        glBeginQuery(GL_TIME_ELAPSED, t.query[t.next]);
+}
+
+void GpuTimers::End()
+{
+    if (!current) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    current->pending[current->next] = true;
+    current->next ^= 1;
+    current = NULL;
+}
+
+void GpuTimers::Report()
+{
+    for (std::map<std::string, Timer>::iterator it=timers.begin();  it!=timers.end();  it++) {
+        Timer& t = it->second;
+        Collect(t, 0);
+        Collect(t, 1);
+        if (t.samples)
+            printf("%s: %.3f ms (mean of %d)\n", it->first.c_str(), t.ms/t.samples, t.samples);
+        t.ms = 0.0;
+        t.samples = 0; }
+}
@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////
+// Timings of passes on the graphics card, by name, without waiting on
+// the results:  the scene times its shadow pass and shadow filter
+// here, ImageOps each of its operations, and any other pass may time
+// itself in the same table.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _GPUTIMERS_
+#define _GPUTIMERS_
+
+#include <map>
+#include <string>
+
+// Timer queries (GL_TIME_ELAPSED) by name.  A query's result is read
+// only once it is available, a frame or two later, so timing never
+// stalls the pipeline.  Operations may not nest.
+class GpuTimers
+{
+ public:
+    GpuTimers();
+    ~GpuTimers();
+
+    void Begin(const char* name);
+    void End();
+
+    // Print each name's mean time since the last report, and start
+    // over.
+    void Report();
+
+ private:
+    struct Timer
+    {
+        unsigned int query[2];  // Alternate, so one may be in flight
+        bool pending[2];
+        int next;
+        double ms;
+        int samples;
+    };
+    std::map<std::string, Timer> timers;
+    Timer* current;
+
+    void Collect(Timer& t, const int i);
+};
+
+#endif
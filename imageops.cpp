@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////
+// Image processing in compute shaders (see imageops.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+#include <glbinding/gl/gl.h>
+#include <glbinding/Binding.h>
+using namespace gl;
+
+#include "shader.h"
+#include "resources.h"
+#include "imageops.h"
+
+#include <glu.h>                // For gluErrorString
+#define CHECKERROR {GLenum err = glGetError(); if (err != GL_NO_ERROR) { fprintf(stderr, "OpenGL error (at line imageops.cpp:%d): %s\n", __LINE__, gluErrorString(err)); exit(-1);} }
+
+// Workgroup shapes, as the shaders declare them
+static const int resampleTile = 8;
+static const int copyTile = 16;
+
+// The modified Bessel function I0, by its series
+static double BesselI0(const double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k=1;  k<30;  k++) {
+        term *= (x/(2.0*k))*(x/(2.0*k));
+        sum += term; }
+    return sum;
+}
+
+ImageOps::ImageOps()
+    : resources(NULL), timers(NULL), downsample(NULL), upsample(NULL), copy(NULL)
+{
+    kaiser[0] = 0.5f;
+    kaiser[1] = 0.0f;
+}
+
+ImageOps::~ImageOps()
+{
+    if (!resources) return;
+    resources->programs.Release(downsample);
+    resources->programs.Release(upsample);
+    resources->programs.Release(copy);
+    for (std::map<std::pair<std::pair<int, int>, unsigned int>, Blur*>::iterator b=blurs.begin();
+         b!=blurs.end();  b++) {
+        glDeleteTextures(1, &b->second->array);
+        delete b->second; }
+}
+
+void ImageOps::Create(Resources* _resources, GpuTimers* _timers)
+{
+    resources = _resources;
+    timers = _timers;
+    downsample = resources->ComputeProgram("downsample.comp");
+    upsample = resources->ComputeProgram("upsample.comp");
+    copy = resources->ComputeProgram("copy.comp");
+
+    // A 2x reduction's Kaiser-windowed sinc (alpha 4), 4 taps across,
+    // at 0.5 and 1.5 source texels each side of the new texel's center
+    const double pi = 3.14159265358979, alpha = 4.0;
+    double sum = 0.0, w[2];
+    for (int i=0;  i<2;  i++) {
+        double x = i + 0.5;
+        double sinc = sin(pi*x/2.0)/(pi*x/2.0);
+        w[i] = sinc*BesselI0(alpha*sqrt(1.0 - (x/2.0)*(x/2.0)))/BesselI0(alpha);
+        sum += 2.0*w[i]; }
+    kaiser[0] = (float)(w[0]/sum);
+    kaiser[1] = (float)(w[1]/sum);
+    CHECKERROR;
+}
+
+// The filter, and its array, for blurs of a w x h image of format,
+// made the first time that size and format is asked for
+ImageOps::Blur* ImageOps::BlurFor(const int w, const int h, const GLenum format)
+{
+    std::pair<std::pair<int, int>, unsigned int> key(std::make_pair(w, h), (unsigned int)format);
+    std::map<std::pair<std::pair<int, int>, unsigned int>, Blur*>::iterator b = blurs.find(key);
+    if (b != blurs.end())
+        return b->second;
+
+    Blur* blur = new Blur;
+    blur->filter.Create(resources, w, h, 1, format);
+    glGenTextures(1, &blur->array);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, blur->array);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, format, w, h, 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, (int)GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, (int)GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    CHECKERROR;
+    blurs[key] = blur;
+    return blur;
+}
+
+unsigned int ImageOps::CreatePyramid(const int w, const int h, const int levels, const GLenum format)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, levels, format, w, h);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (int)GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (int)GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (int)GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    (int)(levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+    glBindTexture(GL_TEXTURE_2D, 0);
+    CHECKERROR;
+    return texture;
+}
+
+// Bind texture for texelFetch as sampler uniform name on unit
+static void BindSource(const int programId, const char* name, const int unit, const unsigned int texture)
+{
+    glActiveTexture((GLenum)((int)GL_TEXTURE0 + unit));
+    glBindTexture(GL_TEXTURE_2D, texture);
+    int loc = glGetUniformLocation(programId, name);
+    glUniform1i(loc, unit);
+}
+
+// Bind level of texture, of format, as writeonly image uniform dst
+static void BindDestination(const int programId, const unsigned int texture, const int level,
+                            const GLenum format)
+{
+    glBindImageTexture(0, texture, level, GL_FALSE, 0, GL_WRITE_ONLY, format);
+    int loc = glGetUniformLocation(programId, "dst");
+    glUniform1i(loc, 0);
+}
+
+void ImageOps::Gaussian(const unsigned int src, const unsigned int dst, const int w, const int h,
+                        const GLenum format, const int radius)
+{
+    Blur* blur = BlurFor(w, h, format);
+    blur->filter.SetGaussian(radius);
+
+    // The filter's passes run array to scratch and back, so the array
+    // may be both their source and destination.
+    timers->Begin("Gaussian");
+    glCopyImageSubData(src, GL_TEXTURE_2D, 0, 0, 0, 0, blur->array, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, w, h, 1);
+    blur->filter.Apply(blur->array, blur->array, w, h);
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glCopyImageSubData(blur->array, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, dst, GL_TEXTURE_2D, 0, 0, 0, 0, w, h, 1);
+    timers->End();
+    CHECKERROR;
+}
+
+void ImageOps::Downsample(const unsigned int pyramid, const int w, const int h, const int levels,
+                          const GLenum format, const DownsampleFilter filter)
+{
+    timers->Begin(filter == DOWNSAMPLE_KAISER ? "Downsample (Kaiser)" : "Downsample (box)");
+    downsample->Use();
+    int programId = downsample->programId;
+    BindSource(programId, "src", 0, pyramid);
+
+    // A box is the Kaiser's 4 taps with the outer two 0.
+    int loc = glGetUniformLocation(programId, "taps");
+    if (filter == DOWNSAMPLE_KAISER)
+        glUniform2f(loc, kaiser[0], kaiser[1]);
+    else
+        glUniform2f(loc, 0.5f, 0.0f);
+
+    for (int i=1;  i<levels;  i++) {
+        int lw = std::max(1, w >> i), lh = std::max(1, h >> i);
+        loc = glGetUniformLocation(programId, "level");
+        glUniform1i(loc, i-1);
+        loc = glGetUniformLocation(programId, "srcSize");
+        glUniform2i(loc, std::max(1, w >> (i-1)), std::max(1, h >> (i-1)));
+        loc = glGetUniformLocation(programId, "dstSize");
+        glUniform2i(loc, lw, lh);
+        BindDestination(programId, pyramid, i, format);
+        glDispatchCompute((lw + resampleTile-1)/resampleTile, (lh + resampleTile-1)/resampleTile, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT); }
+
+    downsample->Unuse();
+    timers->End();
+    CHECKERROR;
+}
+
+void ImageOps::BilateralUpsample(const unsigned int src, const unsigned int lowGuide, const int lw, const int lh,
+                                 const unsigned int highGuide, const unsigned int dst, const int w, const int h,
+                                 const GLenum format, const int channel, const float sigma)
+{
+    timers->Begin("Bilateral upsample");
+    upsample->Use();
+    int programId = upsample->programId;
+    BindSource(programId, "src", 0, src);
+    BindSource(programId, "lowGuide", 1, lowGuide);
+    BindSource(programId, "highGuide", 2, highGuide);
+    BindDestination(programId, dst, 0, format);
+
+    int loc = glGetUniformLocation(programId, "lowSize");
+    glUniform2i(loc, lw, lh);
+    loc = glGetUniformLocation(programId, "highSize");
+    glUniform2i(loc, w, h);
+    loc = glGetUniformLocation(programId, "channel");
+    glUniform1i(loc, channel);
+    loc = glGetUniformLocation(programId, "sigma");
+    glUniform1f(loc, sigma);
+
+    glDispatchCompute((w + resampleTile-1)/resampleTile, (h + resampleTile-1)/resampleTile, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    upsample->Unuse();
+    timers->End();
+    CHECKERROR;
+}
+
+void ImageOps::Copy(const unsigned int src, const unsigned int dst, const int w, const int h,
+                    const GLenum format)
+{
+    timers->Begin("Copy");
+    copy->Use();
+    int programId = copy->programId;
+    BindSource(programId, "src", 0, src);
+    BindDestination(programId, dst, 0, format);
+    int loc = glGetUniformLocation(programId, "size");
+    glUniform2i(loc, w, h);
+
+    glDispatchCompute((w + copyTile-1)/copyTile, (h + copyTile-1)/copyTile, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    copy->Unuse();
+    timers->End();
+    CHECKERROR;
+}
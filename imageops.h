@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////
+// Image processing on the graphics card, by compute shaders, for
+// render targets (an FBO's textureID[i]) and other 2D textures:
+//
+//    Gaussian            a separable blur of any radius, up to
+//                        MaxFilterRadius, by a SeparableFilter
+//    Downsample          a mip pyramid, each level a 2x reduction of
+//                        the one above, by a box or a Kaiser-windowed
+//                        sinc (downsample.comp)
+//    BilateralUpsample   a half (or less) resolution result brought up
+//                        to full, without bleeding across depth edges
+//                        (upsample.comp)
+//    Copy                level 0 of any texture into an image of any
+//                        format, converting as it goes (copy.comp)
+//
+// SeparableFilter works on texture arrays, so Gaussian copies its
+// source into a one layer array kept for that size and format,
+// filters it there, and copies the result out.  The Kaiser taps are
+// worked out once, in Create.  Each operation has its own workgroup
+// shape:  8x8 tiles for the resampling, 16x16 for copies.
+//
+// Every operation is timed on the card, by name, in the GpuTimers
+// given to Create.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _IMAGEOPS_
+#define _IMAGEOPS_
+
+#include <map>
+
+#include "separablefilter.h"
+#include "gputimers.h"
+
+class Resources;
+class ShaderProgram;
+
+// How Downsample filters
+enum DownsampleFilter { DOWNSAMPLE_BOX, DOWNSAMPLE_KAISER };
+
+class ImageOps
+{
+ public:
+    ImageOps();
+    ~ImageOps();
+
+    // Build the programs (shared through resources), timing each
+    // operation in timers.
+    void Create(Resources* resources, GpuTimers* timers);
+
+    // Blur src into dst (both w x h, of format).  The kernel is
+    // uploaded only when radius differs from the last blur of that
+    // size and format.
+    void Gaussian(const unsigned int src, const unsigned int dst, const int w, const int h,
+                  const GLenum format, const int radius);
+
+    // A texture of levels mip levels for a w x h image, of format, for
+    // Downsample and BilateralUpsample.  The caller deletes it.
+    unsigned int CreatePyramid(const int w, const int h, const int levels, const GLenum format);
+
+    // Fill levels 1 to levels-1 of pyramid (of format, w x h at level
+    // 0) each from the level above.
+    void Downsample(const unsigned int pyramid, const int w, const int h, const int levels,
+                    const GLenum format, const DownsampleFilter filter=DOWNSAMPLE_BOX);
+
+    // Resample src (lw x lh) up into dst (w x h, of format).  Of the
+    // four src texels around a pixel, each is weighted bilinearly and
+    // by exp(-d^2/(2 sigma^2)), with d the difference of its guide
+    // value from the pixel's:  channel of lowGuide (lw x lh) and of
+    // highGuide (w x h), typically depth.
+    void BilateralUpsample(const unsigned int src, const unsigned int lowGuide, const int lw, const int lh,
+                           const unsigned int highGuide, const unsigned int dst, const int w, const int h,
+                           const GLenum format, const int channel, const float sigma);
+
+    // Level 0 of src into dst (w x h, of format).
+    void Copy(const unsigned int src, const unsigned int dst, const int w, const int h,
+              const GLenum format);
+
+ private:
+    // A SeparableFilter and the one layer array it filters in place
+    struct Blur
+    {
+        SeparableFilter filter;
+        unsigned int array;
+    };
+
+    Resources* resources;
+    GpuTimers* timers;
+    ShaderProgram *downsample, *upsample, *copy;
+
+    std::map<std::pair<std::pair<int, int>, unsigned int>, Blur*> blurs;    // By size and format
+    float kaiser[2];                            // Downsample taps 0.5 and 1.5 texels from center
+
+    Blur* BlurFor(const int w, const int h, const GLenum format);
+};
+
+#endif
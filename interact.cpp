@@ -66,6 +66,14 @@ void Keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
         case GLFW_KEY_F:
             scene.transformation_mode = !scene.transformation_mode;
             break;
+        case GLFW_KEY_R:        // Drop unused resources and report the rest
+            printf("Evicted %d resources\n", scene.resources->Evict());
+            scene.resources->Report();
+            break;
+        case GLFW_KEY_T:        // Report the GPU timings since the last report
+            scene.gpuTimers.Report();
+            printf("Shadow pass: %d draws\n", scene.shadowDraws);
+            break;
         case GLFW_KEY_ESCAPE: case GLFW_KEY_Q: // Escape and 'q' keys quit the application
             exit(0); } }
         
@@ -1,32 +1,41 @@
 /////////////////////////////////////////////////////////////////////////
 // Pixel shader for lighting
 ////////////////////////////////////////////////////////////////////////
-#version 330
+#version 430
 
 out vec4 FragColor;
 
-// These definitions agree with the ObjectIds enum in scene.h
-const int     nullId	= 0;
-const int     skyId	= 1;
-const int     seaId	= 2;
-const int     groundId	= 3;
-const int     roomId	= 4;
-const int     boxId	= 5;
-const int     frameId	= 6;
-const int     lPicId	= 7;
-const int     rPicId	= 8;
-const int     teapotId	= 9;
-const int     spheresId	= 10;
-const int     floorId	= 11;
-
-in vec3 normalVec, lightVec, eyeVec, tanVec;
+// The material table (see materialtable.h and gbuff.frag)
+const int MAT_SKY_REFLECT = 2;
+const int MAT_REFLECTIVE = 4;
+
+struct Material
+{
+    vec4 diffuse;
+    vec4 specular;
+    vec4 tint;
+    vec4 uvTransform;
+    vec4 uvScroll;
+    ivec4 maps;
+    ivec4 flags;
+};
+
+layout(std430, binding = 0) readonly buffer MaterialTable
+{
+    Material materials[];
+};
+
+uniform sampler2DArray materialMaps[8];     // MaxMaterialArrays
+
+in vec3 normalVec, lightVec, eyeVec;
+
+// Tangent, with the bitangent sign in w.  The normal maps here have
+// green pointing down, hence B = w*cross(T,N) rather than w*cross(N,T).
+in vec4 tanVec;
 in vec2 texCoord;
 in vec4 shadowCoord;
 
-uniform int objectId;
-uniform vec3 diffuse;    // Kd
-uniform vec3 specular;   // Ks
-uniform float shininess; // alpha exponent
+uniform int material;
 uniform float time;
 
 uniform vec3 Light;    // Ii
@@ -35,12 +44,35 @@ uniform vec3 Ambient;  // Ia
 uniform int mode;
 uniform mat4 shadowMatrix;
 uniform sampler2D shadowMap, upperReflect, lowerReflect;
-uniform sampler2D skyTex, groundTex, wallTex, floorTex, teapotTex, frameTex, lFrameTex, rFrameTex;
-uniform sampler2D wallNormal, floorNormal, frameNormal, seaNormal;
+uniform samplerCube skyTex;
 uniform sampler2D worldPosMap, normalVecMap, KdMap, KsMap;
 
-uniform bool reflective;
 
+// The sky maps hold linear radiance, as cube maps looked up by
+// direction.  Where the sky is shown as a color, encode it for display
+// as stb_image's 8 bit decode used to.
+vec3 SkyColor(samplerCube sky, vec3 D)
+{
+    return pow(max(texture(sky, D).xyz, vec3(0.0)), vec3(1.0/2.2));
+}
+
+// Normal maps are stored as BC5, which keeps only x and y;  z is
+// rebuilt from the unit length.
+vec3 NormalMap(int map, int layer, vec2 uv, float strength)
+{
+    vec3 delta;
+    delta.xy = texture(materialMaps[map], vec3(uv, layer)).xy*2.0 - vec2(1,1);
+    delta.z = sqrt(max(0.0, 1.0 - dot(delta.xy, delta.xy)));
+    delta.xy *= strength;
+    return normalize(delta);
+}
+
+// Equirectangular coordinates of direction D, for maps that ripple
+// with the reflection (MAT_SKY_REFLECT)
+vec2 SkyUV(vec3 D)
+{
+    return vec2(-atan(D.y/D.x)/(2*3.14159), acos(D.z)/3.14159);
+}
 
 void LightingFrag()
 {
@@ -50,93 +82,39 @@ void LightingFrag()
     vec3 V = normalize(eyeVec);
     vec3 H = normalize(L+V);
 
-    vec3 Kd = diffuse;   
+    Material m = materials[material];
+    vec3 Kd = m.diffuse.xyz;
+    vec3 specular = m.specular.xyz;
+    float shininess = m.specular.w;
+    bool reflective = (m.flags.x & MAT_REFLECTIVE) != 0;
 
     vec2 shadowIndex = shadowCoord.xy/shadowCoord.w;
 
     bool inShadow  = false;
     if(shadowCoord.w > 0.0 && shadowIndex.x >= 0.0 && shadowIndex.x <= 1.0 && shadowIndex.y >= 0.0 && shadowIndex.y <= 1.0){
-        if(shadowCoord.w > texture2D(shadowMap, shadowIndex).w + 0.01){
+        if(shadowCoord.w > texture(shadowMap, shadowIndex).w + 0.01){
             inShadow = true;
         }
     }
-    
-    /*
-    // A checkerboard pattern to break up larte flat expanses.  Remove when using textures.
-    if (objectId==groundId || objectId==floorId || objectId==seaId) {
-        ivec2 uv = ivec2(floor(100.0*texCoord));
-        if ((uv[0]+uv[1])%2==0)
-            Kd *= 0.9; }
-    */
 
+    // Textures, from the material;  its flags and maps are the same
+    // for the whole draw, so these branches never diverge.
     if(mode < 3){
-        
-        if(objectId == groundId) {
-            Kd = texture(groundTex, texCoord * 100.0).xyz;
-        }
-        else if(objectId == seaId) {
+        vec2 uv = texCoord;
+        if ((m.flags.x & MAT_SKY_REFLECT) != 0) {
             vec3 R = -(2*dot(V,N) * N - V);
-            vec2 uv = vec2(-atan(R.y/R.x)/(2*3.14159), acos(R.z)/3.14159);
-            Kd = texture(skyTex, uv).xyz;
-
-            uv.x -= time * 0.001;
-            uv.y += time * 0.001;
-            vec3 delta = texture(seaNormal, uv * 10.0).xyz;
-            delta = delta*2.0 - vec3(1,1,1);
-            vec3 T = normalize(tanVec);
-            vec3 B = normalize(cross(T,N));
-            N = delta.x*T + delta.y*B + delta.z*N;
-        }
-        else if(objectId == roomId) {
-            vec2 uv = vec2(texCoord.y, -texCoord.x);
-            Kd = texture(wallTex, uv * 20.0).xyz * 0.9;
-        
-            vec3 delta = texture(wallNormal, uv * 20.0).xyz;
-            delta = delta*2.0 - vec3(1,1,1);
-            vec3 T = normalize(tanVec);
-            vec3 B = normalize(cross(T,N));
-            N = delta.x*T + delta.y*B + delta.z*N;
-        }
-        else if(objectId == floorId) {
-            Kd = texture(floorTex, texCoord * 4.0).xyz;
-
-        
-            vec3 delta = texture(floorNormal, texCoord * 4.0).xyz;
-            delta = delta*2.0 - vec3(1,1,1);
-            vec3 T = normalize(tanVec);
-            vec3 B = normalize(cross(T,N));
-            N = delta.x*T + delta.y*B + delta.z*N;
-        
-        }
-        else if(objectId == teapotId) {
-            Kd = texture(teapotTex, texCoord * 8.0).xyz;
-        }
-        else if(objectId == boxId) {
-            Kd = texture(frameTex, texCoord * 1.0).xyz;
-
-            vec3 delta = texture(frameNormal, texCoord * 1.0).xyz;
-            delta = delta*2.0 - vec3(1,1,1);
-            vec3 T = normalize(tanVec);
-            vec3 B = normalize(cross(T,N));
-            N = delta.x*T + delta.y*B + delta.z*N;
-        }
-        else if(objectId == frameId) {
-            Kd = texture(frameTex, texCoord * 1.0).xyz;
-        
-            vec3 delta = texture(frameNormal, texCoord * 1.0).xyz;
-            delta = delta*2.0 - vec3(1,1,1);
-            vec3 T = normalize(tanVec);
-            vec3 B = normalize(cross(T,N));
-            N = delta.x*T + delta.y*B + delta.z*N;
-        
-        }
-        else if(objectId == lPicId) {
-            Kd = texture(lFrameTex, texCoord * 1.0).xyz;
-        }
-        else if(objectId == rPicId) {
-            Kd = texture(rFrameTex, texCoord * 1.0).xyz;
-        }
-        
+            uv = SkyUV(R);
+            Kd = SkyColor(skyTex, R); }
+        uv = mat2(m.uvTransform) * (uv + time*m.uvScroll.xy);
+
+        if (m.maps.x >= 0)
+            Kd = texture(materialMaps[m.maps.x], vec3(uv, m.maps.y)).xyz * m.tint.xyz;
+
+        if (m.maps.z >= 0) {
+            vec3 delta = NormalMap(m.maps.z, m.maps.w, uv, m.tint.w);
+            vec3 T = normalize(tanVec.xyz);
+            vec3 B = tanVec.w*normalize(cross(T,N));
+            N = delta.x*T + delta.y*B + delta.z*N; }
     }
 
     float LN = max(dot(L,N), 0.0);
@@ -144,12 +122,7 @@ void LightingFrag()
     float HL = max(dot(H,L), 0.0);
 
     
-    if (objectId == skyId && mode <= 2) {
-        vec2 uv = vec2(-atan(V.y/V.x)/(2*3.14159), acos(V.z)/3.14159);
-        FragColor.xyz = texture(skyTex, uv).xyz;
-    }
-    
-    else if (mode == 1 || mode == 2) {        // BRDF lighting
+    if (mode == 1 || mode == 2) {        // BRDF lighting
         
         
         if(inShadow){
@@ -157,9 +130,6 @@ void LightingFrag()
         }
         else{
             vec3 F = specular + ((1,1,1) - specular) * pow(1 - HL, 5);
-            if(reflective){
-            
-            }
             float G = 1 / pow(HL, 2);
             float D = ((shininess + 2)/6.28318) * pow(HN, shininess);
             FragColor.xyz = Ambient*Kd + Light * LN * (Kd/3.14159 + ((F*G*D)/4));
@@ -177,19 +147,19 @@ void LightingFrag()
             vec2 uv;
             if(c > 0){
                 uv = vec2(a/(1+c), b/(1+c)) * 0.5 + vec2(0.5, 0.5);
-                FragColor.xyz += max(0.1 * texture2D(upperReflect, uv).xyz, 0.0);
+                FragColor.xyz += max(0.1 * texture(upperReflect, uv).xyz, 0.0);
                 if(mode == 2){
-                    FragColor.xyz = texture2D(upperReflect, uv).xyz;
+                    FragColor.xyz = texture(upperReflect, uv).xyz;
                 }
             }
             else{
                 uv = vec2(a/(1-c), b/(1-c)) * 0.5 + vec2(0.5, 0.5);
-                FragColor.xyz += max(0.1 * texture2D(lowerReflect, uv).xyz, 0.0);
+                FragColor.xyz += max(0.1 * texture(lowerReflect, uv).xyz, 0.0);
                 if(mode == 2){
-                    FragColor.xyz = texture2D(lowerReflect, uv).xyz;
+                    FragColor.xyz = texture(lowerReflect, uv).xyz;
                 }
             }
-            // FragColor.xyz += texture2D(upperReflect, uv).xyz;
+            // FragColor.xyz += texture(upperReflect, uv).xyz;
         }
         
         
@@ -6,14 +6,14 @@
 #version 330
 
 uniform mat4 WorldView, WorldInverse, WorldProj, ModelTr, NormalTr;
-uniform bool reflective;
 
 in vec4 vertex;
 in vec3 vertexNormal;
 in vec2 vertexTexture;
-in vec3 vertexTangent;
+in vec4 vertexTangent;
 
-out vec3 normalVec, lightVec, eyeVec, tanVec;
+out vec3 normalVec, lightVec, eyeVec;
+out vec4 tanVec;
 out vec2 texCoord;
 out vec4 shadowCoord;
 
@@ -37,5 +37,5 @@ void LightingVertex(vec3 eye)
     // vec3 eyePos = (WorldInverse*vec4(0.0, 0.0, 0.0, 1.0)).xyz;
     eyeVec = eye - worldPos;
 
-    tanVec = mat3(ModelTr)*vertexTangent;
+    tanVec = vec4(mat3(ModelTr)*vertexTangent.xyz, vertexTangent.w);
 }
@@ -5,29 +5,11 @@
 
 out vec4 FragColor;
 
-// These definitions agree with the ObjectIds enum in scene.h
-const int     nullId	= 0;
-const int     skyId	= 1;
-const int     seaId	= 2;
-const int     groundId	= 3;
-const int     roomId	= 4;
-const int     boxId	= 5;
-const int     frameId	= 6;
-const int     lPicId	= 7;
-const int     rPicId	= 8;
-const int     teapotId	= 9;
-const int     spheresId	= 10;
-const int     floorId	= 11;
-
 // in vec3 normalVec, lightVec, eyeVec, tanVec;
 in vec2 texCoord;
 // in vec4 shadowCoord;
 in vec4 vertex;
 
-uniform int objectId;
-uniform vec3 diffuse;    // Kd
-uniform vec3 specular;   // Ks
-uniform float shininess; // alpha exponent
 uniform float time;
 
 uniform vec3 Light;    // Ii
@@ -37,12 +19,8 @@ uniform vec3 lightPos;
 uniform int mode;
 uniform mat4 shadowMatrix, WorldInverse;
 uniform sampler2D shadowMap, upperReflect, lowerReflect;
-uniform sampler2D skyTex, groundTex, wallTex, floorTex, teapotTex, frameTex, lFrameTex, rFrameTex;
-uniform sampler2D wallNormal, floorNormal, frameNormal, seaNormal;
 uniform sampler2D worldPosMap, normalVecMap, KdMap, KsMap;
 
-uniform bool reflective;
-
 
 void main()
 {
@@ -12,7 +12,7 @@ uniform vec3 lightPos, eyePos;
 in vec4 vertex;
 in vec3 vertexNormal;
 in vec2 vertexTexture;
-in vec3 vertexTangent;
+in vec4 vertexTangent;
 
 void main()
 {
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////
+// A read-only memory mapping of a whole file.  The file's bytes are
+// available at data[0..size-1] for as long as the MappedFile is open;
+// pages are brought in by the OS on first touch, so large files cost
+// nothing up front and are never copied.
+////////////////////////////////////////////////////////////////////////
+
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Map the named file.  Returns false (leaving the object closed) if
+// the file cannot be opened or is empty.
+bool MappedFile::Open(const char* name)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE f = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (f == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(f, &length) || length.QuadPart == 0) {
+        CloseHandle(f);
+        return false; }
+
+    HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!m) {
+        CloseHandle(f);
+        return false; }
+
+    void* view = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(m);
+        CloseHandle(f);
+        return false; }
+
+    file = f;
+    mapping = m;
+    data = (const char*)view;
+    size = (size_t)length.QuadPart;
+#else
+    int fd = open(name, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false; }
+
+    void* view = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);                  // The mapping keeps the file alive
+    if (view == MAP_FAILED)
+        return false;
+    madvise(view, st.st_size, MADV_SEQUENTIAL);
+
+    data = (const char*)view;
+    size = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+// Unmap the file (if open).
+void MappedFile::Close()
+{
+    if (!data)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mapping);
+    CloseHandle((HANDLE)file);
+#else
+    munmap((void*)data, size);
+#endif
+    data = NULL;
+    size = 0;
+    file = mapping = NULL;
+}
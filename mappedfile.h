@@ -0,0 +1,33 @@
+///////////////////////////////////////////////////////////////////////
+// A read-only memory mapping of a whole file.  The file's bytes are
+// available at data[0..size-1] for as long as the MappedFile is open;
+// pages are brought in by the OS on first touch, so large files cost
+// nothing up front and are never copied.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _MAPPEDFILE_
+#define _MAPPEDFILE_
+
+#include <stddef.h>
+
+class MappedFile
+{
+ public:
+    const char* data;
+    size_t size;
+
+    MappedFile() : data(NULL), size(0), file(NULL), mapping(NULL) {}
+    ~MappedFile() { Close(); }
+
+    bool Open(const char* name);
+    void Close();
+
+ private:
+    void* file;                 // Platform file handle (Windows only)
+    void* mapping;              // Platform mapping handle (Windows only)
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+#endif
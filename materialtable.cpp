@@ -0,0 +1,166 @@
+///////////////////////////////////////////////////////////////////////
+// Material texture arrays and the material table (see materialtable.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <map>
+#include <algorithm>
+
+#include <glbinding/gl/gl.h>
+#include <glbinding/Binding.h>
+using namespace gl;
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "materialtable.h"
+
+#include <glu.h>                // For gluErrorString
+#define CHECKERROR {GLenum err = glGetError(); if (err != GL_NO_ERROR) { fprintf(stderr, "OpenGL error (at line materialtable.cpp:%d): %s\n", __LINE__, gluErrorString(err)); exit(-1);} }
+
+Material::Material(const glm::vec3 _d, const glm::vec3 _s, const float _n, const int _flags)
+    : diffuse(_d), specular(_s), shininess(_n), flags(_flags),
+      tint(1.0f), normalStrength(1.0f), uvTransform(1.0f), uvScroll(0.0f), index(-1)
+{}
+
+MaterialTable::MaterialTable(TextureLoader* _loader, ResourceCache<Texture>* _cache)
+    : built(false), loader(_loader), cache(_cache), buffer(0), dirty(true)
+{
+    glGenBuffers(1, &buffer);
+    Add(new Material(glm::vec3(0.5f), glm::vec3(0.0f), 1));
+}
+
+MaterialTable::~MaterialTable()
+{
+    for (size_t i=0;  i<maps.size();  i++)
+        cache->Release(maps[i].texture);
+    for (size_t i=0;  i<materials.size();  i++)
+        delete materials[i];
+    if (!arrays.empty())
+        glDeleteTextures(arrays.size(), &arrays[0]);
+    glDeleteBuffers(1, &buffer);
+}
+
+Material* MaterialTable::Add(Material* material)
+{
+    material->index = materials.size();
+    materials.push_back(material);
+
+    MaterialEntry e;
+    e.diffuse = glm::vec4(material->diffuse, 0.0f);
+    e.specular = glm::vec4(material->specular, material->shininess);
+    e.tint = glm::vec4(material->tint, material->normalStrength);
+    e.uvTransform = glm::vec4(material->uvTransform[0], material->uvTransform[1]);
+    e.uvScroll = glm::vec4(material->uvScroll, 0.0f, 0.0f);
+    e.maps = glm::ivec4(-1, -1, -1, -1);
+    e.flags = glm::ivec4(material->flags, 0, 0, 0);
+    entries.push_back(e);
+
+    // Normal maps hold vectors, not sRGB colors (see MipChain::Load).
+    if (!material->albedo.empty()) {
+        Map m = { loader->Load(material->albedo), material->index, 0 };
+        maps.push_back(m); }
+    if (!material->normal.empty()) {
+        Map m = { loader->Load(material->normal, glm::vec4(0.5f, 0.5f, 1.0f, 1.0f), false), material->index, 1 };
+        maps.push_back(m); }
+    built = built && maps.empty();
+    dirty = true;
+    return material;
+}
+
+void MaterialTable::Update()
+{
+    if (!built) {
+        bool ready = true;
+        for (size_t i=0;  i<maps.size() && ready;  i++)
+            ready = maps[i].texture->ready;
+        if (ready) Pack(); }
+    if (dirty) Upload();
+}
+
+// Copy each texture not yet packed, level by level, into a layer of a
+// new array for its format, size and level count.  The copies are made on the card
+// (glCopyImageSubData), compressed blocks and all.
+void MaterialTable::Pack()
+{
+    // Layers by group, each distinct texture once
+    typedef std::pair<std::pair<unsigned int, int>, std::pair<int, int> > Group;
+    std::map<Group, std::vector<Texture*> > groups;
+    std::map<Texture*, std::pair<int, int> > place;     // Array and layer
+    for (size_t i=0;  i<maps.size();  i++) {
+        Texture* t = maps[i].texture;
+        if (place.count(t)) continue;
+        Group g(std::make_pair(t->internalFormat, t->levels), std::make_pair(t->width, t->height));
+        place[t] = std::make_pair(-1, (int)groups[g].size());
+        groups[g].push_back(t); }
+
+    if ((int)groups.size() > MaxMaterialArrays) {
+        printf("MaterialTable needs %d texture arrays, but shaders take %d\n",
+               (int)groups.size(), MaxMaterialArrays);
+        exit(-1); }
+
+    size_t bytes = 0;
+    for (std::map<Group, std::vector<Texture*> >::iterator g=groups.begin();  g!=groups.end();  g++) {
+        std::vector<Texture*>& layers = g->second;
+        Texture* first = layers[0];
+        GLuint id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, first->levels, (GLenum)first->internalFormat,
+                       first->width, first->height, layers.size());
+        for (size_t l=0;  l<layers.size();  l++) {
+            for (int i=0;  i<first->levels;  i++) {
+                int w = std::max(1, first->width >> i), h = std::max(1, first->height >> i);
+                glCopyImageSubData(layers[l]->textureId, GL_TEXTURE_2D, i, 0, 0, 0,
+                                   id, GL_TEXTURE_2D_ARRAY, i, 0, 0, l, w, h, 1); }
+            place[layers[l]].first = arrays.size();
+            bytes += layers[l]->bytes; }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, (int)GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, (int)GL_LINEAR_MIPMAP_LINEAR);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        arrays.push_back(id); }
+    CHECKERROR;
+
+    for (size_t i=0;  i<maps.size();  i++) {
+        std::pair<int, int> p = place[maps[i].texture];
+        glm::ivec4& m = entries[maps[i].entry].maps;
+        m[2*maps[i].which] = p.first;
+        m[2*maps[i].which+1] = p.second; }
+
+    // The arrays hold the only copies needed now.
+    for (size_t i=0;  i<maps.size();  i++)
+        cache->Release(maps[i].texture);
+    maps.clear();
+    cache->Evict();
+
+    printf("MaterialTable: %d textures in %d arrays, %.2f MB\n",
+           (int)place.size(), (int)arrays.size(), bytes/(1024.0*1024.0));
+    built = true;
+    dirty = true;
+}
+
+void MaterialTable::Upload()
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, entries.size()*sizeof(MaterialEntry),
+                 entries.empty() ? NULL : &entries[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    CHECKERROR;
+    dirty = false;
+}
+
+void MaterialTable::Bind(const int programId, const int firstUnit)
+{
+    int units[MaxMaterialArrays];
+    for (int i=0;  i<MaxMaterialArrays;  i++) {
+        units[i] = firstUnit + i;
+        glActiveTexture((GLenum)((int)GL_TEXTURE0 + units[i]));
+        glBindTexture(GL_TEXTURE_2D_ARRAY, i < (int)arrays.size() ? arrays[i] : 0); }
+    int loc = glGetUniformLocation(programId, "materialMaps");
+    glUniform1iv(loc, MaxMaterialArrays, units);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, materialBindpoint, buffer);
+    CHECKERROR;
+}
@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////
+// Materials:  everything about an object's surface that its shaders
+// need (colors, shininess, textures, how to transform texture
+// coordinates, and flags).  Objects hold a Material;  several objects
+// may share one.
+//
+// The MaterialTable keeps every material as an entry of a shader
+// storage buffer, and their textures packed into a few
+// GL_TEXTURE_2D_ARRAYs.  A shader picks its material with one index
+// per draw (uniform "material"), so it needs no per-object branches,
+// and adding a material needs no change to any shader.
+//
+// Textures go into arrays grouped by format, size and mipmap count;
+// each group is one array, and each texture one layer.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _MATERIALTABLE_
+#define _MATERIALTABLE_
+
+#include <string>
+#include <vector>
+
+#include "texture.h"
+
+// The most arrays a shader can sample (materialMaps[] in gbuff.frag)
+const int MaxMaterialArrays = 8;
+
+// Shader storage binding point of the table
+const int materialBindpoint = 0;
+
+enum MaterialFlags {
+    MAT_SKY_REFLECT = 2,        // Color is the reflected sky;  maps are
+                                // sampled with the reflection's coordinates
+    MAT_REFLECTIVE = 4          // Lit with the sky's irradiance (multilight.frag)
+};
+
+class Material
+{
+ public:
+    glm::vec3 diffuse;          // Kd, where there is no albedo map
+    glm::vec3 specular;         // Ks
+    float shininess;            // alpha exponent
+    int flags;                  // MaterialFlags
+
+    std::string albedo;         // Image files, or empty
+    std::string normal;
+    glm::vec3 tint;             // Multiplies the albedo map
+    float normalStrength;       // Scales the normal map's tilt;  0 ignores it
+
+    // Texture coordinates are transformed as uvTransform*(uv + time*uvScroll).
+    glm::mat2 uvTransform;
+    glm::vec2 uvScroll;
+
+    int index;                  // Entry in the MaterialTable;  -1 until added
+
+    Material(const glm::vec3 _d=glm::vec3(), const glm::vec3 _s=glm::vec3(), const float _n=1,
+             const int _flags=0);
+};
+
+// One entry, laid out as struct Material (std430) in the shaders
+struct MaterialEntry
+{
+    glm::vec4 diffuse;          // xyz:  Kd
+    glm::vec4 specular;         // xyz:  Ks,  w:  shininess
+    glm::vec4 tint;             // xyz:  multiplies the albedo map,  w:  normal map strength
+    glm::vec4 uvTransform;      // Columns of a 2x2 matrix applied to texture coordinates
+    glm::vec4 uvScroll;         // xy:  added to coordinates per unit of time
+    glm::ivec4 maps;            // Albedo array and layer, normal array and layer;  -1 for none
+    glm::ivec4 flags;           // x:  MaterialFlags
+};
+
+class MaterialTable
+{
+ public:
+    std::vector<Material*> materials;   // Owned;  materials[i]->index == i
+    std::vector<MaterialEntry> entries;
+    bool built;                 // Every map is in an array
+
+    // Entry 0 is a plain gray material, for objects that have none.
+    MaterialTable(TextureLoader* _loader, ResourceCache<Texture>* _cache);
+    ~MaterialTable();
+
+    // Take ownership of material, give it the next entry, and start
+    // loading its textures.  Returns material.
+    Material* Add(Material* material);
+
+    // Called each frame.  Uploads the table;  once every texture has
+    // arrived, packs them into arrays, gives the separate textures back
+    // to the cache, and uploads the table again with the maps filled in.
+    void Update();
+
+    // Bind the arrays to units firstUnit on, and the table to its
+    // binding point, for the program in use.
+    void Bind(const int programId, const int firstUnit);
+
+ private:
+    struct Map
+    {
+        Texture* texture;
+        int entry;              // Entry and which of its maps (0 albedo, 1 normal)
+        int which;
+    };
+
+    TextureLoader* loader;
+    ResourceCache<Texture>* cache;
+    std::vector<Map> maps;
+    std::vector<unsigned int> arrays;   // GL texture ids
+    unsigned int buffer;                // The table's SSBO
+    bool dirty;
+
+    void Pack();
+    void Upload();
+};
+
+#endif
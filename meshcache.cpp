@@ -0,0 +1,261 @@
+///////////////////////////////////////////////////////////////////////
+// A disk cache of generated and loaded shapes (see meshcache.h).
+//
+// File layout, all in native byte order:
+//    MeshCacheHeader
+//    key bytes
+//    Pnt, Nrm, Tex, Tan, Tri arrays, each starting on a 16 byte boundary
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "shapes.h"
+#include "meshcache.h"
+#include "mappedfile.h"
+
+// Bump whenever the layout, or any generator that uses the cache,
+// changes, so old entries are rebuilt rather than trusted.
+static const uint32_t MeshCacheVersion = 1;
+static const char MeshCacheMagic[8] = { 'M','E','S','H','C','A','C','H' };
+static const char* MeshCacheDir = "meshcache";
+
+struct MeshCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t keySize;
+    uint32_t counts[5];         // Sizes of Pnt, Nrm, Tex, Tan, Tri
+    float minP[3], maxP[3];
+};
+
+static size_t Align16(const size_t n) { return (n + 15) & ~(size_t)15; }
+
+MeshCache::MeshCache(const std::string& name, const std::string& _key)
+    : path(std::string(MeshCacheDir) + "/" + name + ".mesh"), key(_key)
+{
+}
+
+////////////////////////////////////////////////////////////////////////
+// Reading
+
+template<class T> static const char* Stream(const char* p, std::vector<T>& v, const uint32_t n)
+{
+    p = (const char*)Align16((size_t)p);
+    const T* begin = (const T*)p;
+    v.assign(begin, begin+n);
+    return p + n*sizeof(T);
+}
+
+bool MeshCache::Load(Shape* shape)
+{
+    MappedFile file;
+    if (!file.Open(path.c_str()))
+        return false;
+
+    MeshCacheHeader h;
+    if (file.size < sizeof(h)) return false;
+    memcpy(&h, file.data, sizeof(h));
+    if (memcmp(h.magic, MeshCacheMagic, sizeof(h.magic)) != 0
+        || h.version != MeshCacheVersion
+        || h.keySize != key.size()
+        || file.size < sizeof(h) + h.keySize
+        || memcmp(file.data + sizeof(h), key.data(), key.size()) != 0) {
+        printf("MeshCache %s is stale; rebuilding\n", path.c_str());
+        return false; }
+
+    // The streams are 16-aligned relative to the file start, which the
+    // mapping puts on a page boundary.
+    const size_t sizes[5] = { sizeof(glm::vec4), sizeof(glm::vec3), sizeof(glm::vec2),
+                              sizeof(glm::vec4), sizeof(glm::ivec3) };
+    size_t end = sizeof(h) + h.keySize;
+    for (int i=0;  i<5;  i++)
+        end = Align16(end) + h.counts[i]*sizes[i];
+    if (file.size < end) {
+        printf("MeshCache %s is truncated; rebuilding\n", path.c_str());
+        return false; }
+
+    const char* p = file.data + sizeof(h) + h.keySize;
+    p = Stream(p, shape->Pnt, h.counts[0]);
+    p = Stream(p, shape->Nrm, h.counts[1]);
+    p = Stream(p, shape->Tex, h.counts[2]);
+    p = Stream(p, shape->Tan, h.counts[3]);
+    p = Stream(p, shape->Tri, h.counts[4]);
+    shape->minP = glm::vec3(h.minP[0], h.minP[1], h.minP[2]);
+    shape->maxP = glm::vec3(h.maxP[0], h.maxP[1], h.maxP[2]);
+    shape->bounded = h.counts[0] > 0;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Writing
+
+// Reorder triangles so that consecutive ones share vertices, for the
+// post-transform vertex cache.  This is Tipsify (Sander, Nehab and
+// Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced
+// Overdraw", 2007):  it fans out from the current vertex, then moves to
+// the most recently used vertex that still has triangles left and will
+// stay in a cache of the given size.  Only triangle order changes,
+// never the winding within a triangle.
+static void OptimizeIndices(std::vector<glm::ivec3>& Tri, const size_t nv, const int cacheSize=16)
+{
+    const size_t nt = Tri.size();
+    for (size_t t=0;  t<nt;  t++)
+        for (int c=0;  c<3;  c++)
+            if (Tri[t][c] < 0 || (size_t)Tri[t][c] >= nv) return;
+
+    // Triangles around each vertex, as adj[offset[v] .. offset[v+1]-1].
+    std::vector<int> offset(nv+1, 0), adj(3*nt);
+    for (size_t t=0;  t<nt;  t++)
+        for (int c=0;  c<3;  c++)
+            offset[Tri[t][c]+1]++;
+    for (size_t v=0;  v<nv;  v++)
+        offset[v+1] += offset[v];
+    std::vector<int> fill(offset.begin(), offset.end()-1);
+    for (size_t t=0;  t<nt;  t++)
+        for (int c=0;  c<3;  c++)
+            adj[fill[Tri[t][c]]++] = t;
+
+    std::vector<int> live(nv);          // Triangles not yet emitted
+    for (size_t v=0;  v<nv;  v++)
+        live[v] = offset[v+1] - offset[v];
+    std::vector<int> stamp(nv, 0);      // When each vertex entered the cache
+    std::vector<char> emitted(nt, 0);
+    std::vector<int> deadEnd, candidates;
+    std::vector<glm::ivec3> out;
+    out.reserve(nt);
+
+    int time = cacheSize+1;
+    size_t cursor = 0;
+    int f = nv ? 0 : -1;
+    while (f >= 0) {
+        candidates.clear();
+        for (int a=offset[f];  a<offset[f+1];  a++) {
+            int t = adj[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+            out.push_back(Tri[t]);
+            for (int c=0;  c<3;  c++) {
+                int v = Tri[t][c];
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - stamp[v] > cacheSize) {
+                    stamp[v] = time;
+                    time++; } } }
+
+        // Prefer a vertex that is still cached after fanning around it.
+        f = -1;
+        int best = -1;
+        for (size_t i=0;  i<candidates.size();  i++) {
+            int v = candidates[i];
+            if (live[v] <= 0) continue;
+            int priority = 0;
+            if (time - stamp[v] + 2*live[v] <= cacheSize)
+                priority = time - stamp[v];
+            if (priority > best) {
+                best = priority;
+                f = v; } }
+
+        // Otherwise back up through recent vertices, then scan forward.
+        while (f < 0 && !deadEnd.empty()) {
+            int v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) f = v; }
+        while (f < 0 && cursor < nv) {
+            if (live[cursor] > 0) f = cursor;
+            cursor++; } }
+
+    Tri.swap(out);
+}
+
+template<class T> static void WriteStream(FILE* f, const std::vector<T>& v)
+{
+    static const char zero[16] = { 0 };
+    long at = ftell(f);
+    fwrite(zero, 1, Align16(at) - at, f);
+    if (!v.empty())
+        fwrite(&v[0], sizeof(T), v.size(), f);
+}
+
+void MeshCache::Save(Shape* shape)
+{
+    OptimizeIndices(shape->Tri, shape->Pnt.size());
+
+    MeshCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MeshCacheMagic, sizeof(h.magic));
+    h.version = MeshCacheVersion;
+    h.keySize = key.size();
+    h.counts[0] = shape->Pnt.size();
+    h.counts[1] = shape->Nrm.size();
+    h.counts[2] = shape->Tex.size();
+    h.counts[3] = shape->Tan.size();
+    h.counts[4] = shape->Tri.size();
+
+    if (!shape->Pnt.empty()) {
+        shape->minP = shape->maxP = shape->Pnt[0].xyz();
+        for (size_t i=0;  i<shape->Pnt.size();  i++) {
+            shape->minP = glm::min(shape->minP, shape->Pnt[i].xyz());
+            shape->maxP = glm::max(shape->maxP, shape->Pnt[i].xyz()); }
+        shape->bounded = true; }
+    for (int c=0;  c<3;  c++) {
+        h.minP[c] = shape->minP[c];
+        h.maxP[c] = shape->maxP[c]; }
+
+#ifdef _WIN32
+    _mkdir(MeshCacheDir);
+#else
+    mkdir(MeshCacheDir, 0777);
+#endif
+
+    // Write to a temporary and rename, so a crash never leaves a
+    // truncated entry under the real name.
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) {
+        printf("MeshCache cannot write %s\n", tmp.c_str());
+        return; }
+    fwrite(&h, sizeof(h), 1, f);
+    fwrite(key.data(), 1, key.size(), f);
+    WriteStream(f, shape->Pnt);
+    WriteStream(f, shape->Nrm);
+    WriteStream(f, shape->Tex);
+    WriteStream(f, shape->Tan);
+    WriteStream(f, shape->Tri);
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok;
+
+    remove(path.c_str());
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        printf("MeshCache cannot write %s\n", path.c_str());
+        remove(tmp.c_str()); }
+}
+
+std::string MeshCache::FileHash(const char* name)
+{
+    // 64 bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    MappedFile file;
+    if (file.Open(name))
+        for (size_t i=0;  i<file.size;  i++)
+            hash = (hash ^ (unsigned char)file.data[i]) * 1099511628211ULL;
+
+    char buf[17];
+    sprintf(buf, "%016llx", (unsigned long long)hash);
+    return buf;
+}
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////
+// A disk cache of generated and loaded shapes.  Each entry is one
+// binary file under meshcache/ holding a Shape's data arrays (with
+// triangles reordered for the vertex cache) and bounds, tagged with a
+// key describing how it was made: the generator and its parameters, or
+// a hash of the source file.  A later run with the same key maps the
+// file and copies the arrays out in bulk instead of rebuilding them.
+//
+// Typical use in a Shape constructor:
+//    MeshCache cache("sphere-32", "Sphere n=32");
+//    if (!cache.Load(this)) {
+//        ... fill Pnt, Nrm, Tex, Tan, Tri ...
+//        cache.Save(this); }
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _MESHCACHE_
+#define _MESHCACHE_
+
+#include <string>
+
+class Shape;
+
+class MeshCache
+{
+ public:
+    std::string path;           // The entry's file
+    std::string key;            // Must match the stored key for a hit
+
+    // name selects the file, so a shape whose key changes from run to
+    // run still occupies only one entry.
+    MeshCache(const std::string& name, const std::string& key);
+
+    // Fill shape's data arrays and minP/maxP (and bounded) from the
+    // entry.  Returns false if there is no entry or it is stale
+    // (other key, other format version, or truncated).
+    bool Load(Shape* shape);
+
+    // Reorder shape->Tri for the vertex cache, set shape->minP/maxP
+    // (and bounded), and write the entry.  Failure to write is reported, not fatal.
+    void Save(Shape* shape);
+
+    // A hash of a file's contents, for keys of shapes read from disk.
+    static std::string FileHash(const char* name);
+};
+
+#endif
@@ -0,0 +1,449 @@
+///////////////////////////////////////////////////////////////////////
+// Mipmap chains built once and cached on disk (see mipchain.h).
+//
+// Cache file layout, in native byte order:
+//    MipHeader
+//    key bytes
+//    level 0, level 1, ... packed together, starting on a 16 byte boundary
+// The header's format field is a MipFormat.
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "stb_image.h"
+#include "mipchain.h"
+
+// Bump whenever the layout or the filter changes.
+static const uint32_t MipChainVersion = 4;
+static const char MipChainMagic[8] = { 'M','I','P','C','H','A','I','N' };
+static const char* MipChainDir = "texcache";
+
+// Radiance .hdr files as BC6H;  false keeps them as RGB9_E5.
+static const bool CompressHdr = true;
+
+struct MipHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t keySize;
+    uint32_t width, height, levels;
+    uint32_t format;
+};
+
+static size_t Align16(const size_t n) { return (n + 15) & ~(size_t)15; }
+
+////////////////////////////////////////////////////////////////////////
+// Filtering.  Each level is made from the one above by a separable
+// [1 3 3 1]/8 filter centered on each 2x2 block, which aliases much
+// less than a plain 2x2 box.  Colors are filtered in
+// linear light so that, e.g., a black and white checkerboard fades to
+// the right grey.  A pixel's four channels are one SSE register.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+typedef __m128 Pixel;
+static inline Pixel LoadPixel(const float* p) { return _mm_loadu_ps(p); }
+static inline void StorePixel(float* p, const Pixel v) { _mm_storeu_ps(p, v); }
+static inline Pixel Taps(const Pixel a, const Pixel b, const Pixel c, const Pixel d)
+{
+    return _mm_mul_ps(_mm_add_ps(_mm_add_ps(a, d), _mm_mul_ps(_mm_set1_ps(3.0f), _mm_add_ps(b, c))),
+                      _mm_set1_ps(0.125f));
+}
+
+#else
+
+typedef glm::vec4 Pixel;
+static inline Pixel LoadPixel(const float* p) { return glm::vec4(p[0], p[1], p[2], p[3]); }
+static inline void StorePixel(float* p, const Pixel v) { p[0]=v[0];  p[1]=v[1];  p[2]=v[2];  p[3]=v[3]; }
+static inline Pixel Taps(const Pixel a, const Pixel b, const Pixel c, const Pixel d)
+{
+    return (a + d + 3.0f*(b + c))*0.125f;
+}
+
+#endif
+
+// Halve the w by h float RGBA image src into dst.
+static void Downsample(const float* src, const int w, const int h, float* dst, std::vector<float>& tmp)
+{
+    int w2 = std::max(1, w/2), h2 = std::max(1, h/2);
+
+    // Horizontal pass, w by h to w2 by h
+    tmp.resize((size_t)w2*h*4);
+    for (int y=0;  y<h;  y++) {
+        const float* row = src + (size_t)y*w*4;
+        float* out = &tmp[(size_t)y*w2*4];
+        for (int x=0;  x<w2;  x++) {
+            int a = std::max(2*x-1, 0), b = std::min(2*x, w-1);
+            int c = std::min(2*x+1, w-1), d = std::min(2*x+2, w-1);
+            StorePixel(out + 4*x, Taps(LoadPixel(row+4*a), LoadPixel(row+4*b),
+                                       LoadPixel(row+4*c), LoadPixel(row+4*d))); } }
+
+    // Vertical pass, w2 by h to w2 by h2
+    for (int y=0;  y<h2;  y++) {
+        const float* A = &tmp[(size_t)std::max(2*y-1, 0)*w2*4];
+        const float* B = &tmp[(size_t)std::min(2*y,   h-1)*w2*4];
+        const float* C = &tmp[(size_t)std::min(2*y+1, h-1)*w2*4];
+        const float* D = &tmp[(size_t)std::min(2*y+2, h-1)*w2*4];
+        float* out = dst + (size_t)y*w2*4;
+        for (int x=0;  x<4*w2;  x+=4)
+            StorePixel(out + x, Taps(LoadPixel(A+x), LoadPixel(B+x), LoadPixel(C+x), LoadPixel(D+x))); }
+}
+
+static float SrgbToLinear(const float c)
+{
+    return c <= 0.04045f ? c/12.92f : powf((c + 0.055f)/1.055f, 2.4f);
+}
+
+static float LinearToSrgb(const float c)
+{
+    return c <= 0.0031308f ? 12.92f*c : 1.055f*powf(c, 1.0f/2.4f) - 0.055f;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Packed float formats, following the conversions in the GL
+// specification.  Negative values and NaNs become 0;  values too large
+// for the format become its largest finite value.
+
+// Shared-exponent RGB9_E5:  three 9 bit mantissas and a 5 bit exponent.
+uint32_t PackRgb9e5(const float r, const float g, const float b)
+{
+    const float largest = 511.0f/512.0f*65536.0f;
+    float rc = r > 0.0f ? std::min(r, largest) : 0.0f;
+    float gc = g > 0.0f ? std::min(g, largest) : 0.0f;
+    float bc = b > 0.0f ? std::min(b, largest) : 0.0f;
+    float maxc = std::max(rc, std::max(gc, bc));
+
+    int e;                      // maxc = m*2^e, m in [0.5,1)
+    frexpf(maxc, &e);
+    int exp = std::max(-16, e-1) + 1 + 15;
+    if ((int)floorf(maxc/ldexpf(1.0f, exp-24) + 0.5f) == 512) exp++;
+    float scale = ldexpf(1.0f, exp-24);
+    uint32_t rs = (uint32_t)floorf(rc/scale + 0.5f);
+    uint32_t gs = (uint32_t)floorf(gc/scale + 0.5f);
+    uint32_t bs = (uint32_t)floorf(bc/scale + 0.5f);
+    return rs | (gs << 9) | (bs << 18) | ((uint32_t)exp << 27);
+}
+
+// An unsigned float with a 5 bit exponent and an mbits bit mantissa
+static uint32_t PackUFloat(const float v, const int mbits)
+{
+    const uint32_t largest = (30u << mbits) | ((1u << mbits) - 1);
+    if (!(v > 0.0f)) return 0;
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    int e = (int)(bits >> 23) - 127 + 15;
+    uint32_t m = bits & 0x7fffff;
+    if (e >= 31) return largest;
+    if (e <= 0) {               // Denormal
+        if (e < -mbits) return 0;
+        m = (m | 0x800000) >> (1 - e);
+        e = 0; }
+    uint32_t out = ((uint32_t)e << mbits) + ((m + (1u << (22-mbits))) >> (23-mbits));
+    return std::min(out, largest);
+}
+
+static uint32_t PackR11G11B10(const float r, const float g, const float b)
+{
+    return PackUFloat(r, 6) | (PackUFloat(g, 6) << 11) | (PackUFloat(b, 5) << 22);
+}
+
+static void UnpackRgb9e5(const uint32_t texel, float* rgb)
+{
+    float scale = ldexpf(1.0f, (int)(texel >> 27) - 15 - 9);
+    for (int c=0;  c<3;  c++)
+        rgb[c] = ((texel >> (9*c)) & 511)*scale;
+}
+
+static float UnpackUFloat(const uint32_t bits, const int mbits)
+{
+    int e = (int)(bits >> mbits);
+    float m = (float)(bits & ((1u << mbits) - 1));
+    if (e == 0) return ldexpf(m, -14 - mbits);                  // Denormal
+    return ldexpf(1.0f + m/(float)(1 << mbits), e - 15);
+}
+
+static void UnpackR11G11B10(const uint32_t texel, float* rgb)
+{
+    rgb[0] = UnpackUFloat(texel & 0x7ff, 6);
+    rgb[1] = UnpackUFloat((texel >> 11) & 0x7ff, 6);
+    rgb[2] = UnpackUFloat(texel >> 22, 5);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Building
+
+void MipChain::Allocate(const MipFormat _format)
+{
+    format = _format;
+    levels = 1;
+    while (levels < MaxMipLevels && (std::max(width, height) >> levels) > 0)
+        levels++;
+
+    size_t total = 0;
+    for (int i=0;  i<levels;  i++)
+        total += LevelSize(i);
+    pixels.resize(total);
+
+    size_t offset = 0;
+    for (int i=0;  i<levels;  i++) {
+        level[i] = &pixels[offset];
+        offset += LevelSize(i); }
+}
+
+// Write level i from linear float RGBA.
+void MipChain::Store(const int i, const float* src, const bool srgb)
+{
+    unsigned char* out = &pixels[level[i] - &pixels[0]];
+    size_t n = (size_t)LevelWidth(i)*LevelHeight(i);
+    if (format == MIP_RGBA8)
+        for (size_t j=0;  j<4*n;  j++) {
+            float c = glm::clamp(src[j], 0.0f, 1.0f);
+            if (srgb && j%4 != 3) c = LinearToSrgb(c);
+            out[j] = (unsigned char)(255.0f*c + 0.5f); }
+    else if (format == MIP_BC6H)
+        CompressBlocksHdr(src, LevelWidth(i), LevelHeight(i), out);
+    else
+        for (size_t j=0;  j<n;  j++) {
+            const float* p = src + 4*j;
+            uint32_t texel = format == MIP_RGB9E5 ? PackRgb9e5(p[0], p[1], p[2])
+                                                  : PackR11G11B10(p[0], p[1], p[2]);
+            memcpy(out + 4*j, &texel, sizeof(texel)); }
+}
+
+// Fill levels 1 and up from level 0, given as linear float RGBA in cur.
+void MipChain::Reduce(std::vector<float>& cur, const bool srgb)
+{
+    std::vector<float> next, tmp;
+    for (int i=1;  i<levels;  i++) {
+        next.resize((size_t)LevelWidth(i)*LevelHeight(i)*4);
+        Downsample(&cur[0], LevelWidth(i-1), LevelHeight(i-1), &next[0], tmp);
+        Store(i, &next[0], srgb);
+        cur.swap(next); }
+}
+
+void MipChain::Build(const unsigned char* rgba, const bool srgb)
+{
+    Allocate(MIP_RGBA8);
+    memcpy(&pixels[0], rgba, LevelSize(0));
+
+    float decode[256];
+    for (int i=0;  i<256;  i++)
+        decode[i] = srgb ? SrgbToLinear(i/255.0f) : i/255.0f;
+
+    std::vector<float> cur(LevelSize(0));
+    for (size_t i=0;  i<cur.size();  i++)
+        cur[i] = i%4 == 3 ? rgba[i]/255.0f : decode[rgba[i]];
+    Reduce(cur, srgb);
+}
+
+void MipChain::BuildHdr(const float* rgba, const MipFormat hdrFormat)
+{
+    Allocate(hdrFormat);
+    std::vector<float> cur(rgba, rgba + (size_t)width*height*4);
+    Store(0, &cur[0], false);
+    Reduce(cur, false);
+}
+
+// Replace the RGBA8 levels by block-compressed ones.  The format is
+// chosen once for the whole chain, from level 0.
+void MipChain::Compress(const bool srgb)
+{
+    bool opaque = true;
+    for (size_t i=3;  i<LevelSize(0) && opaque;  i+=4)
+        opaque = level[0][i] == 255;
+    BlockFormat block = !srgb ? BLOCK_BC5 : opaque ? BLOCK_BC1 : BLOCK_BC3;
+
+    size_t total = 0;
+    for (int i=0;  i<levels;  i++)
+        total += BlockSize(block, LevelWidth(i), LevelHeight(i));
+    std::vector<unsigned char> blocks(total);
+    size_t offset = 0;
+    for (int i=0;  i<levels;  i++) {
+        CompressBlocks(block, level[i], LevelWidth(i), LevelHeight(i), &blocks[offset]);
+        offset += BlockSize(block, LevelWidth(i), LevelHeight(i)); }
+
+    format = block == BLOCK_BC1 ? MIP_BC1 : block == BLOCK_BC3 ? MIP_BC3 : MIP_BC5;
+    pixels.swap(blocks);
+    offset = 0;
+    for (int i=0;  i<levels;  i++) {
+        level[i] = &pixels[offset];
+        offset += LevelSize(i); }
+}
+
+////////////////////////////////////////////////////////////////////////
+// The cache
+
+bool MipChain::Map(const std::string& cache, const std::string& key)
+{
+    if (!file.Open(cache.c_str()))
+        return false;
+
+    MipHeader h;
+    bool ok = file.size >= sizeof(h);
+    if (ok) {
+        memcpy(&h, file.data, sizeof(h));
+        ok = memcmp(h.magic, MipChainMagic, sizeof(h.magic)) == 0
+            && h.version == MipChainVersion
+            && h.keySize == key.size()
+            && h.levels >= 1 && h.levels <= (uint32_t)MaxMipLevels
+            && h.format <= (uint32_t)MIP_BC6H
+            && file.size >= sizeof(h) + h.keySize
+            && memcmp(file.data + sizeof(h), key.data(), key.size()) == 0; }
+    if (!ok) {
+        printf("MipChain %s is stale; rebuilding\n", cache.c_str());
+        file.Close();
+        return false; }
+
+    width = h.width;
+    height = h.height;
+    levels = h.levels;
+    format = (MipFormat)h.format;
+    size_t offset = Align16(sizeof(h) + h.keySize);
+    for (int i=0;  i<levels;  i++) {
+        level[i] = (const unsigned char*)file.data + offset;
+        offset += LevelSize(i); }
+    if (file.size < offset) {
+        printf("MipChain %s is truncated; rebuilding\n", cache.c_str());
+        file.Close();
+        return false; }
+    return true;
+}
+
+void MipChain::Save(const std::string& cache, const std::string& key)
+{
+    MipHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MipChainMagic, sizeof(h.magic));
+    h.version = MipChainVersion;
+    h.keySize = key.size();
+    h.width = width;
+    h.height = height;
+    h.levels = levels;
+    h.format = format;
+
+#ifdef _WIN32
+    _mkdir(MipChainDir);
+#else
+    mkdir(MipChainDir, 0777);
+#endif
+
+    // Write to a temporary and rename, so a crash never leaves a
+    // truncated chain under the real name.
+    std::string tmp = cache + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) {
+        printf("MipChain cannot write %s\n", tmp.c_str());
+        return; }
+    static const char zero[16] = { 0 };
+    fwrite(&h, sizeof(h), 1, f);
+    fwrite(key.data(), 1, key.size(), f);
+    fwrite(zero, 1, Align16(sizeof(h) + key.size()) - (sizeof(h) + key.size()), f);
+    fwrite(&pixels[0], 1, pixels.size(), f);
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok;
+
+    remove(cache.c_str());
+    if (!ok || rename(tmp.c_str(), cache.c_str()) != 0) {
+        printf("MipChain cannot write %s\n", cache.c_str());
+        remove(tmp.c_str()); }
+}
+
+// Levels are stored bottom row first, as the loaders in this program
+// ask of stb_image (stbi_set_flip_vertically_on_load).
+bool MipChain::Load(const std::string& path, const bool srgb)
+{
+    MappedFile source;
+    if (!source.Open(path.c_str())) {
+        reason = "can't open file";
+        return false; }
+
+    // 64 bit FNV-1a of the source, so an edited image is reconverted.
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i=0;  i<source.size;  i++)
+        hash = (hash ^ (unsigned char)source.data[i]) * 1099511628211ULL;
+
+    char buf[64];
+    sprintf(buf, " srgb=%d hash=%016llx", srgb, (unsigned long long)hash);
+    std::string key = "MipChain " + path + buf;
+    std::string name(path);
+    for (size_t i=0;  i<name.size();  i++)
+        if (name[i] == '/' || name[i] == '\\' || name[i] == ':') name[i] = '_';
+    std::string cache = std::string(MipChainDir) + "/" + name + ".mip";
+
+    if (Map(cache, key))
+        return true;
+
+    // High dynamic range images keep their float values:  BC6H for
+    // Radiance .hdr files (or shared-exponent RGB9_E5, which matches
+    // their RGBE pixels), packed R11F_G11F_B10F otherwise.  Both packed
+    // formats take 4 bytes a texel, BC6H 1.
+    int n;
+    const unsigned char* data = (const unsigned char*)source.data;
+    if (stbi_is_hdr_from_memory(data, (int)source.size)) {
+        float* rgba = stbi_loadf_from_memory(data, (int)source.size, &width, &height, &n, 4);
+        if (!rgba) {
+            reason = stbi_failure_reason();
+            return false; }
+        size_t dot = path.rfind('.');
+        std::string ext = dot == std::string::npos ? "" : path.substr(dot);
+        for (size_t i=0;  i<ext.size();  i++) ext[i] = tolower(ext[i]);
+        BuildHdr(rgba, ext != ".hdr" ? MIP_R11G11B10F : CompressHdr ? MIP_BC6H : MIP_RGB9E5);
+        stbi_image_free(rgba);
+        Save(cache, key);
+        return true; }
+
+    unsigned char* rgba = stbi_load_from_memory(data, (int)source.size, &width, &height, &n, 4);
+    if (!rgba) {
+        reason = stbi_failure_reason();
+        return false; }
+    Build(rgba, srgb);
+    stbi_image_free(rgba);
+    Compress(srgb);
+    Save(cache, key);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Decoding
+
+void MipChain::Decode(const int i, float* rgba) const
+{
+    size_t n = (size_t)LevelWidth(i)*LevelHeight(i);
+    if (format == MIP_RGB9E5 || format == MIP_R11G11B10F) {
+        for (size_t j=0;  j<n;  j++) {
+            uint32_t texel;
+            memcpy(&texel, level[i] + 4*j, sizeof(texel));
+            if (format == MIP_RGB9E5) UnpackRgb9e5(texel, rgba + 4*j);
+            else                      UnpackR11G11B10(texel, rgba + 4*j);
+            rgba[4*j+3] = 1.0f; }
+        return; }
+    if (format == MIP_BC6H) {
+        DecompressBlocksHdr(level[i], LevelWidth(i), LevelHeight(i), rgba);
+        return; }
+
+    const unsigned char* bytes = level[i];
+    std::vector<unsigned char> blocks;
+    if (format != MIP_RGBA8) {
+        blocks.resize(4*n);
+        BlockFormat block = format == MIP_BC1 ? BLOCK_BC1 : format == MIP_BC3 ? BLOCK_BC3 : BLOCK_BC5;
+        DecompressBlocks(block, level[i], LevelWidth(i), LevelHeight(i), &blocks[0]);
+        bytes = &blocks[0]; }
+    for (size_t j=0;  j<4*n;  j++)
+        rgba[j] = bytes[j]/255.0f;
+}
@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////
+// An image together with its whole mipmap chain, ready to upload level
+// by level.  Chains are built once from a source image with a
+// gamma-correct filter, block-compressed (see blockcompress.h) and kept
+// under texcache/, keyed by a hash of the source file;  later runs
+// memory-map the cached chain instead of decoding the source and
+// calling glGenerateMipmap.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _MIPCHAIN_
+#define _MIPCHAIN_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "mappedfile.h"
+#include "blockcompress.h"
+
+// As many levels as GL_TEXTURE_MAX_LEVEL=10 allows
+const int MaxMipLevels = 11;
+
+// How the levels are stored:  opaque colors as BC1, colors with alpha
+// as BC3, and normal maps (srgb false) as BC5, which keeps x and y.
+// High dynamic range images stay floating point:  Radiance .hdr files
+// as BC6H, 1 byte a texel, others as R11F_G11F_B10F, 4 bytes a texel
+// like RGBA8.  RGB9_E5, also 4 bytes, is the uncompressed choice for
+// .hdr (see CompressHdr in mipchain.cpp).
+enum MipFormat { MIP_RGBA8, MIP_BC1, MIP_BC3, MIP_BC5, MIP_RGB9E5, MIP_R11G11B10F, MIP_BC6H };
+
+// One RGB9_E5 texel (GL_UNSIGNED_INT_5_9_9_9_REV) from linear RGB
+uint32_t PackRgb9e5(const float r, const float g, const float b);
+
+class MipChain
+{
+ public:
+    int width, height;          // Of level 0
+    int levels;
+    MipFormat format;
+    const unsigned char* level[MaxMipLevels];   // Pixels of each level, bottom row first
+    const char* reason;         // Why Load failed
+
+    MipChain() : width(0), height(0), levels(0), format(MIP_RGBA8), reason(NULL) {}
+
+    // Fill the chain for an image file.  srgb says the pixels are
+    // sRGB-encoded colors (filtered in linear space) rather than data
+    // such as normals (filtered as stored);  it does not apply to high
+    // dynamic range images, which are linear.  Returns false if the
+    // source cannot be read.
+    bool Load(const std::string& path, const bool srgb=true);
+
+    int LevelWidth(const int i) const  { return width  >> i ? width  >> i : 1; }
+    int LevelHeight(const int i) const { return height >> i ? height >> i : 1; }
+    size_t LevelSize(const int i) const
+    {
+        switch (format) {
+        case MIP_BC1: return BlockSize(BLOCK_BC1, LevelWidth(i), LevelHeight(i));
+        case MIP_BC3: return BlockSize(BLOCK_BC3, LevelWidth(i), LevelHeight(i));
+        case MIP_BC5: return BlockSize(BLOCK_BC5, LevelWidth(i), LevelHeight(i));
+        case MIP_BC6H: return BlockSize(BLOCK_BC6H, LevelWidth(i), LevelHeight(i));
+        default: return (size_t)LevelWidth(i)*LevelHeight(i)*4; }
+    }
+
+    // Level i as float RGBA (LevelWidth*LevelHeight*4 floats), as a
+    // shader would read it:  stored values, not linearized, with
+    // block-compressed levels decompressed and packed floats unpacked.
+    void Decode(const int i, float* rgba) const;
+
+ private:
+    MappedFile file;                    // A cached chain, or
+    std::vector<unsigned char> pixels;  // one built by this run
+
+    bool Map(const std::string& cache, const std::string& key);
+    void Allocate(const MipFormat _format);
+    void Store(const int i, const float* src, const bool srgb);
+    void Reduce(std::vector<float>& cur, const bool srgb);
+    void Build(const unsigned char* rgba, const bool srgb);
+    void BuildHdr(const float* rgba, const MipFormat hdrFormat);
+    void Compress(const bool srgb);
+    void Save(const std::string& cache, const std::string& key);
+
+    MipChain(const MipChain&);
+    MipChain& operator=(const MipChain&);
+};
+
+#endif
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////
+// Moment shadow mapping's constants, for C++ and GLSL alike:  the
+// optimized quantization (Peters and Klein, "Moment Shadow Mapping",
+// 2015), an affine map taking the moments of a depth in [0,1] into
+// [0,1]^4 so 16 bits a channel keep enough precision, with its
+// inverse, and the reconstruction's biases.
+//
+// The numbers are written once, below.  momentshadow.cpp uses them
+// directly;  shaders get them from MomentsGLSL, which the programs
+// that need it insert after their #version line (see
+// ShaderProgram::AddShader).
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _MOMENTS_
+#define _MOMENTS_
+
+// The quantization, q = M b + (offset, 0, 0, 0), and its inverse,
+// b = M' (q - (offset, 0, 0, 0)).  The matrices column by column.
+#define MOMENT_QUANTIZE_OFFSET 0.035955884801f
+#define MOMENT_QUANTIZE_MATRIX                                         \
+    -2.07224649f,   13.7948857237f,  0.105877704f,   9.7924062118f,    \
+    32.23703778f,  -59.4683975703f, -1.9077466311f, -33.7652110555f,   \
+    -68.571074599f, 82.0359750338f,  9.3496555107f,  47.9456096605f,   \
+    39.3703274134f, -35.364903257f, -6.6543490743f, -23.9728048165f
+#define MOMENT_DEQUANTIZE_MATRIX                                       \
+    0.2227744146f, 0.1549679261f, 0.1451988946f, 0.163127443f,         \
+    0.0771972861f, 0.1394629426f, 0.2120202157f, 0.2591432266f,        \
+    0.7926986636f, 0.7963415838f, 0.7258694464f, 0.6539092497f,        \
+    0.0319417555f, -0.1722823173f, -0.2758014811f, -0.3376131734f
+
+// The reconstruction's alpha:  for 32 bit float moments, and for 16
+// bit quantized or summed-area ones
+#define MOMENT_BIAS 0.000009f
+#define MOMENT_BIAS_QUANTIZED 0.00006f
+
+#define MOMENT_STRING_(...) #__VA_ARGS__
+#define MOMENT_STRING(...) MOMENT_STRING_(__VA_ARGS__)
+
+// The same in GLSL (version 1.30 or later, for the f suffixes)
+const char* const MomentsGLSL =
+    "const float MomentBias = " MOMENT_STRING(MOMENT_BIAS) ";\n"
+    "const float MomentBiasQuantized = " MOMENT_STRING(MOMENT_BIAS_QUANTIZED) ";\n"
+    "vec4 QuantizeMoments(vec4 b)\n"
+    "{\n"
+    "    vec4 q = mat4(" MOMENT_STRING(MOMENT_QUANTIZE_MATRIX) ") * b;\n"
+    "    q.x += " MOMENT_STRING(MOMENT_QUANTIZE_OFFSET) ";\n"
+    "    return q;\n"
+    "}\n"
+    "vec4 DequantizeMoments(vec4 q)\n"
+    "{\n"
+    "    q.x -= " MOMENT_STRING(MOMENT_QUANTIZE_OFFSET) ";\n"
+    "    return mat4(" MOMENT_STRING(MOMENT_DEQUANTIZE_MATRIX) ") * q;\n"
+    "}\n";
+
+#endif
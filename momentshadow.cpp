@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////
+// Moment shadow reconstruction on the CPU (see momentshadow.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+
+#include "momentshadow.h"
+
+glm::vec4 QuantizeMoments(const glm::vec4& b)
+{
+    glm::vec4 q = glm::mat4(MOMENT_QUANTIZE_MATRIX) * b;
+    q.x += MOMENT_QUANTIZE_OFFSET;
+    return q;
+}
+
+glm::vec4 DequantizeMoments(const glm::vec4& q)
+{
+    glm::vec4 b = q;
+    b.x -= MOMENT_QUANTIZE_OFFSET;
+    return glm::mat4(MOMENT_DEQUANTIZE_MATRIX) * b;
+}
+
+float MomentShadow(const glm::vec4& b, const float zf, const float alpha)
+{
+    glm::vec4 bPrime = (1.0f - alpha)*b + alpha*glm::vec4(0.5f);
+
+    // The Hankel matrix of (1, b) by Cholesky:  M = L L^T, with L's
+    // rows (a), (b c), (d e f) here named as in the shader.
+    float m12 = bPrime.x, m13 = bPrime.y, m22 = bPrime.y, m23 = bPrime.z, m33 = bPrime.w;
+    float a = 1.0f;
+    float lb = m12/a;
+    float lc = m13/a;
+    float d = sqrtf(m22 - lb*lb);
+    float e = (m23 - lb*lc)/d;
+    float f = sqrtf(m33 - lc*lc - e*e);
+
+    // Solve M c = (1, zf, zf^2), forward then back.
+    float c1H = 1.0f/a;
+    float c2H = (zf - lb*c1H)/d;
+    float c3H = (zf*zf - lc*c1H - e*c2H)/f;
+    float c3 = c3H/f;
+    float c2 = (c2H - e*c3)/d;
+    float c1 = (c1H - lb*c2 - lc*c3)/a;
+
+    // The roots of c1 + c2 z + c3 z^2, in order
+    float root = sqrtf(c2*c2 - 4.0f*c1*c3);
+    float z2 = (-c2 - root)/(2.0f*c3);
+    float z3 = (-c2 + root)/(2.0f*c3);
+    if (z2 > z3) {
+        float tmp = z2;
+        z2 = z3;
+        z3 = tmp; }
+
+    if (zf <= z2)
+        return 0.0f;
+    if (zf <= z3)
+        return (zf*z3 - bPrime.x*(zf + z3) + bPrime.y)/((z3 - z2)*(zf - z2));
+    return 1.0f - (z2*z3 - bPrime.x*(z2 + z3) + bPrime.y)/((zf - z2)*(zf - z3));
+}
+
+////////////////////////////////////////////////////////////////////////
+// Four receivers at a time, one to a lane
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+typedef __m128 Quad;
+static inline Quad Load(const float* p) { return _mm_loadu_ps(p); }
+static inline void Store(float* p, const Quad a) { _mm_storeu_ps(p, a); }
+static inline Quad Set(const float a) { return _mm_set1_ps(a); }
+static inline Quad Add(const Quad a, const Quad b) { return _mm_add_ps(a, b); }
+static inline Quad Sub(const Quad a, const Quad b) { return _mm_sub_ps(a, b); }
+static inline Quad Mul(const Quad a, const Quad b) { return _mm_mul_ps(a, b); }
+static inline Quad Div(const Quad a, const Quad b) { return _mm_div_ps(a, b); }
+static inline Quad Sqrt(const Quad a) { return _mm_sqrt_ps(a); }
+static inline Quad Min(const Quad a, const Quad b) { return _mm_min_ps(a, b); }
+static inline Quad Max(const Quad a, const Quad b) { return _mm_max_ps(a, b); }
+
+// a <= b ? x : y, lane by lane
+static inline Quad SelectLessEqual(const Quad a, const Quad b, const Quad x, const Quad y)
+{
+    Quad m = _mm_cmple_ps(a, b);
+    return _mm_or_ps(_mm_and_ps(m, x), _mm_andnot_ps(m, y));
+}
+
+// Four moment vectors into one register a component
+static inline void Transpose(const glm::vec4* b, Quad& x, Quad& y, Quad& z, Quad& w)
+{
+    x = _mm_loadu_ps(&b[0][0]);
+    y = _mm_loadu_ps(&b[1][0]);
+    z = _mm_loadu_ps(&b[2][0]);
+    w = _mm_loadu_ps(&b[3][0]);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+#else
+
+typedef glm::vec4 Quad;
+static inline Quad Load(const float* p) { return glm::vec4(p[0], p[1], p[2], p[3]); }
+static inline void Store(float* p, const Quad a) { p[0]=a[0];  p[1]=a[1];  p[2]=a[2];  p[3]=a[3]; }
+static inline Quad Set(const float a) { return glm::vec4(a); }
+static inline Quad Add(const Quad a, const Quad b) { return a + b; }
+static inline Quad Sub(const Quad a, const Quad b) { return a - b; }
+static inline Quad Mul(const Quad a, const Quad b) { return a * b; }
+static inline Quad Div(const Quad a, const Quad b) { return a / b; }
+static inline Quad Sqrt(const Quad a) { return glm::sqrt(a); }
+static inline Quad Min(const Quad a, const Quad b) { return glm::min(a, b); }
+static inline Quad Max(const Quad a, const Quad b) { return glm::max(a, b); }
+static inline Quad SelectLessEqual(const Quad a, const Quad b, const Quad x, const Quad y)
+{
+    Quad r;
+    for (int k=0;  k<4;  k++) r[k] = a[k] <= b[k] ? x[k] : y[k];
+    return r;
+}
+static inline void Transpose(const glm::vec4* b, Quad& x, Quad& y, Quad& z, Quad& w)
+{
+    for (int k=0;  k<4;  k++) {
+        x[k] = b[k].x;  y[k] = b[k].y;  z[k] = b[k].z;  w[k] = b[k].w; }
+}
+
+#endif
+
+// MomentShadow, step for step, on four lanes.  The Hankel matrix's
+// first entry is 1, so L's first row is too.
+static void MomentShadow4(const glm::vec4* b, const float* zf, float* shadow, const float alpha)
+{
+    Quad b1, b2, b3, b4;
+    Transpose(b, b1, b2, b3, b4);
+    Quad keep = Set(1.0f - alpha), bias = Set(0.5f*alpha);
+    b1 = Add(Mul(keep, b1), bias);
+    b2 = Add(Mul(keep, b2), bias);
+    b3 = Add(Mul(keep, b3), bias);
+    b4 = Add(Mul(keep, b4), bias);
+    Quad z = Load(zf);
+    Quad one = Set(1.0f), zero = Set(0.0f);
+
+    Quad lb = b1, lc = b2;
+    Quad d = Sqrt(Sub(b2, Mul(lb, lb)));
+    Quad e = Div(Sub(b3, Mul(lb, lc)), d);
+    Quad f = Sqrt(Sub(Sub(b4, Mul(lc, lc)), Mul(e, e)));
+
+    Quad c2H = Div(Sub(z, lb), d);
+    Quad c3H = Div(Sub(Sub(Mul(z, z), lc), Mul(e, c2H)), f);
+    Quad c3 = Div(c3H, f);
+    Quad c2 = Div(Sub(c2H, Mul(e, c3)), d);
+    Quad c1 = Sub(Sub(one, Mul(lb, c2)), Mul(lc, c3));
+
+    Quad root = Sqrt(Sub(Mul(c2, c2), Mul(Set(4.0f), Mul(c1, c3))));
+    Quad twoC3 = Mul(Set(2.0f), c3);
+    Quad r0 = Div(Sub(Sub(zero, c2), root), twoC3);
+    Quad r1 = Div(Add(Sub(zero, c2), root), twoC3);
+    Quad z2 = Min(r0, r1), z3 = Max(r0, r1);
+
+    Quad between = Div(Add(Sub(Mul(z, z3), Mul(b1, Add(z, z3))), b2),
+                       Mul(Sub(z3, z2), Sub(z, z2)));
+    Quad beyond = Sub(one, Div(Add(Sub(Mul(z2, z3), Mul(b1, Add(z2, z3))), b2),
+                               Mul(Sub(z, z2), Sub(z, z3))));
+    Store(shadow, SelectLessEqual(z, z2, zero, SelectLessEqual(z, z3, between, beyond)));
+}
+
+void MomentShadow(const glm::vec4* b, const float* zf, float* shadow, const int n, const float alpha)
+{
+    int i = 0;
+    for (;  i+4<=n;  i+=4)
+        MomentShadow4(b+i, zf+i, shadow+i, alpha);
+    for (;  i<n;  i++)
+        shadow[i] = MomentShadow(b[i], zf[i], alpha);
+}
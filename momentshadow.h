@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////
+// Moment shadow mapping's reconstruction on the CPU:  from the four
+// moments b = (E[z], E[z^2], E[z^3], E[z^4]) of the depths over a
+// filter's footprint, the fraction of them in front of a receiver at
+// depth zf, by the Hamburger 4 moment method (Peters and Klein,
+// "Moment Shadow Mapping", 2015), exactly as MomentShadow in
+// multilight.frag:
+//
+//    Bias b toward (0.5, 0.5, 0.5, 0.5) by alpha, solve the 3x3 Hankel
+//    system of b for c by Cholesky, and take the quadratic c's roots
+//    z2 <= z3;  the shadow follows from where zf falls among them.
+//
+// For a software path, and for studying the precision of the biasing
+// and the quantization offline.  The batch form evaluates four
+// receivers a lane each in SSE registers (plain floats without SSE2).
+// Not linked into the application;  "make test" builds and runs its
+// checks (momentshadowtest.cpp).
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _MOMENTSHADOW_
+#define _MOMENTSHADOW_
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "moments.h"
+
+// The shader's alpha:  for 32 bit float moments, and for 16 bit
+// quantized or summed-area ones
+const float MomentBias = MOMENT_BIAS;
+const float MomentBiasQuantized = MOMENT_BIAS_QUANTIZED;
+
+// The shadow (0 lit, 1 fully blocked) at depth zf from moments b,
+// biased by alpha.
+float MomentShadow(const glm::vec4& b, const float zf, const float alpha=MomentBias);
+
+// The same for each of n moments and depths, into shadow.
+void MomentShadow(const glm::vec4* b, const float* zf, float* shadow, const int n,
+                  const float alpha=MomentBias);
+
+// The optimized quantization (moments.h), and its inverse
+glm::vec4 QuantizeMoments(const glm::vec4& b);
+glm::vec4 DequantizeMoments(const glm::vec4& q);
+
+#endif
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////
+// Checks of the CPU moment shadow reconstruction (momentshadow.h),
+// against shadows whose answer is known.  Built and run by
+// "make test";  exits nonzero if any check fails.
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "momentshadow.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) { if (!(cond)) { printf("FAILED (line %d): ", __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } }
+
+// The moments of a single depth z
+static glm::vec4 Moments(const float z)
+{
+    return glm::vec4(z, z*z, z*z*z, z*z*z*z);
+}
+
+// Equal, or both NaN
+static bool Same(const float a, const float b)
+{
+    return a == b || (a != a && b != b);
+}
+
+int main()
+{
+    // A single blocker at 0.4:  nothing in front of it, everything
+    // well behind it
+    glm::vec4 one = Moments(0.4f);
+    float s = MomentShadow(one, 0.3f);
+    CHECK(s == 0.0f, "single blocker, in front: %g", s);
+    s = MomentShadow(one, 0.5f);
+    CHECK(s > 0.99f && s <= 1.0f, "single blocker, behind: %g", s);
+    s = MomentShadow(one, 0.9f);
+    CHECK(s > 0.999f && s <= 1.0f, "single blocker, far behind: %g", s);
+
+    // Half the footprint at 0.3, half at 0.7:  half shadowed between
+    s = MomentShadow(0.5f*Moments(0.3f) + 0.5f*Moments(0.7f), 0.5f);
+    CHECK(fabsf(s - 0.5f) < 0.01f, "50/50 pair, between: %g", s);
+
+    // The quantization and back, over a range of moments
+    for (int i=0;  i<=100;  i++) {
+        float z = i/100.0f;
+        glm::vec4 b = 0.25f*Moments(z) + 0.75f*Moments(1.0f - 0.5f*z);
+        glm::vec4 q = QuantizeMoments(b);
+        float err = glm::length(DequantizeMoments(q) - b);
+        CHECK(err < 1e-5f, "quantize round trip at %g: error %g", z, err); }
+
+    // The batch form against the scalar one, lane for lane, with n not
+    // a multiple of 4 so the scalar tail runs too
+    const int n = 1003;
+    glm::vec4* b = new glm::vec4[n];
+    float* zf = new float[n];
+    float* batch = new float[n];
+    srand(1);
+    for (int i=0;  i<n;  i++) {
+        float w = rand()/(float)RAND_MAX;
+        b[i] = w*Moments(rand()/(float)RAND_MAX) + (1.0f - w)*Moments(rand()/(float)RAND_MAX);
+        zf[i] = rand()/(float)RAND_MAX; }
+    MomentShadow(b, zf, batch, n);
+    for (int i=0;  i<n;  i++) {
+        float scalar = MomentShadow(b[i], zf[i]);
+        CHECK(Same(batch[i], scalar), "batch %d: %g, scalar %g", i, batch[i], scalar); }
+    delete[] b;
+    delete[] zf;
+    delete[] batch;
+
+    if (failures)
+        printf("%d checks failed\n", failures);
+    else
+        printf("All moment shadow checks passed\n");
+    return failures ? 1 : 0;
+}
@@ -5,52 +5,92 @@
 
 out vec4 FragColor;
 
-// These definitions agree with the ObjectIds enum in scene.h
-const int     nullId	= 0;
-const int     skyId	= 1;
-const int     seaId	= 2;
-const int     groundId	= 3;
-const int     roomId	= 4;
-const int     boxId	= 5;
-const int     frameId	= 6;
-const int     lPicId	= 7;
-const int     rPicId	= 8;
-const int     teapotId	= 9;
-const int     spheresId	= 10;
-const int     floorId	= 11;
+// Material flags (see materialtable.h), which the G-buffer pass
+// writes to KdMap's w
+const int MAT_REFLECTIVE = 4;
+const int OBJ_NO_SHADOW = 256;  // See object.h
 
 // in vec3 normalVec, lightVec, eyeVec, tanVec;
 in vec2 texCoord;
-in vec4 shadowCoord;
 
-uniform int objectId;
-uniform vec3 diffuse;    // Kd
-uniform vec3 specular;   // Ks
-uniform float shininess; // alpha exponent
 uniform float time;
 
 uniform vec3 Light;    // Ii
 uniform vec3 Ambient;  // Ia
 uniform vec3 lightPos;
 
-uniform mat4 WorldInverse;
+uniform mat4 WorldInverse, WorldView;
 
 uniform int mode;
 // uniform mat4 ShadowMatrix;
-uniform sampler2D shadowMap, upperReflect, lowerReflect, choleskyMap;
-uniform sampler2D skyTex, groundTex, wallTex, floorTex, teapotTex, frameTex, lFrameTex, rFrameTex;
-uniform sampler2D skyIrr, skyIrr2;
-uniform sampler2D wallNormal, floorNormal, frameNormal, seaNormal;
+uniform sampler2D upperReflect, lowerReflect;
+uniform sampler2DArray choleskyMap;     // Blurred moments, a layer a cascade
+uniform bool quantized;         // choleskyMap holds quantized moments (see filter-h.comp)
+
+// With summedArea, the moments are instead box filtered pixel by pixel
+// out of satMap (see summedarea.h), over a box as wide as the
+// penumbra:  cascadePenumbra[i] texels per unit of depth from blocker
+// to receiver.  Blockers are looked for searchRadius texels around.
+uniform bool summedArea;
+uniform usampler2DArray satMap;
+uniform float cascadePenumbra[4];
+uniform int searchRadius;
+const int maxRadius = 127;      // Boxes up to 255 texels wide sum exactly
+uniform samplerCube skyIrr, skyIrr2;     // Irradiance, by normal
 uniform sampler2D worldPosMap, normalVecMap, KdMap, KsMap;
 
-uniform bool reflective;
-
 uniform HammersleyBlock {
     float NN;
     float hammersley[2*100]; 
 };
 
 
+// The shadow cascades (see cascades.h):  cascade i covers view depths
+// up to cascadeFar[i], and CascadeMatrix[i] takes a world point to
+// (u, v, depth) in layer i, whose first cascadeExtent[i] of u and v
+// it uses.
+uniform int cascades;
+uniform float cascadeFar[4];
+uniform float cascadeExtent[4];
+uniform mat4 CascadeMatrix[4];
+
+// The cascade covering world point P, and P's coordinates in it;  -1
+// beyond the last.
+int Cascade(vec3 P, out vec3 coord)
+{
+    coord = vec3(0.0);
+    float d = -(WorldView*vec4(P, 1.0)).z;
+    for (int i=0;  i<cascades;  i++)
+        if (d <= cascadeFar[i]) {
+            coord = (CascadeMatrix[i]*vec4(P, 1.0)).xyz;
+            float margin = 0.5/float(textureSize(choleskyMap, 0).x);
+            coord.xy = clamp(coord.xy, vec2(margin), vec2(cascadeExtent[i] - margin));
+            return i; }
+    return -1;
+}
+
+// DequantizeMoments and the MomentBias constants come first, from
+// MomentsGLSL (moments.h).
+
+// A box's sum is exact modulo 2^32, so satMap's sums may wrap.
+uvec4 SatFetch(int layer, ivec2 p)
+{
+    return p.x < 0 || p.y < 0 ? uvec4(0) : texelFetch(satMap, ivec3(p, layer), 0);
+}
+
+// The mean moments over a box r texels each side of texel p, within
+// the part of the layer its cascade uses
+vec4 BoxMoments(int layer, ivec2 p, int r)
+{
+    int n = int(cascadeExtent[layer]*float(textureSize(satMap, 0).x));
+    ivec2 lo = clamp(p - r, ivec2(0), ivec2(n - 1)) - 1;
+    ivec2 hi = clamp(p + r, ivec2(0), ivec2(n - 1));
+    uvec4 sum = SatFetch(layer, hi) - SatFetch(layer, ivec2(lo.x, hi.y))
+        - SatFetch(layer, ivec2(hi.x, lo.y)) + SatFetch(layer, lo);
+    vec2 size = vec2(hi - lo);
+    return vec4(sum)/(65535.0*size.x*size.y);
+}
+
 vec3 cholesky(float m11, float m12, float m13, float m22, float m23, float m33, float z1, float z2, float z3){
     float a = sqrt(m11);
     float b = m12/a;
@@ -69,6 +109,54 @@ vec3 cholesky(float m11, float m12, float m13, float m22, float m23, float m33,
     return vec3(c1,c2,c3);
 }
 
+// The fraction of light blocked at depth zf, by the 4 moment
+// (Hamburger) reconstruction from moments b, as stored in the map
+float MomentShadow(vec4 b, float zf)
+{
+    if (quantized)
+        b = DequantizeMoments(b);
+
+    // Pulls b toward the interior of the valid moments, more so to
+    // survive the rounding of 16 bit channels.
+    float alpha = quantized || summedArea ? MomentBiasQuantized : MomentBias;
+    vec4 bPrime = (1-alpha)*b + alpha*vec4(0.5, 0.5, 0.5, 0.5);
+
+    float z1 = 1.0;
+    float z2 = zf;
+    float z3 = zf*zf;
+
+    float m11 = 1;
+    float m12 = bPrime.x;
+    float m13 = bPrime.y;
+    float m22 = bPrime.y;
+    float m23 = bPrime.z;
+    float m33 = bPrime.w;
+
+    vec3 Cs = cholesky(m11,m12,m13,m22,m23,m33, z1,z2,z3);
+
+    // (-b +- sqrt(b*b - 4*a*c)) / (2*a)
+    z2 = (-Cs.y - sqrt(Cs.y*Cs.y - 4*Cs.x*Cs.z)) / (2*Cs.z);
+    z3 = (-Cs.y + sqrt(Cs.y*Cs.y - 4*Cs.x*Cs.z)) / (2*Cs.z);
+
+    if(z2 > z3){
+        float tmp = z2;
+        z2 = z3;
+        z3 = tmp;
+    }
+
+    float Gs = 0.0;
+    if(zf <= z2){
+        Gs = 0.0;
+    }
+    else if(zf <= z3){
+        Gs = (zf*z3 - bPrime.x*(zf+z3) + bPrime.y) / ((z3-z2)*(zf-z2));
+    }
+    else{
+        Gs = 1.0 - (z2*z3 - bPrime.x*(z2+z3) + bPrime.y) / ((zf-z2)*(zf-z3));
+    }
+    return Gs;
+}
+
 void main()
 {
     vec2 uv = gl_FragCoord.xy/vec2(1000, 1000);
@@ -84,67 +172,49 @@ void main()
     vec3 H = normalize(L+V);
     
     vec3 Kd = texture(KdMap, uv).xyz;
+    int flags = int(round(texture(KdMap, uv).w));
+    bool reflective = (flags & MAT_REFLECTIVE) != 0;
+    bool receivesShadow = (flags & OBJ_NO_SHADOW) == 0;
     vec3 Ks = texture(KsMap, uv).xyz;
     float a = texture(KsMap, uv).w;
 
-    if(a == -1 && (mode <= 2 || mode >= 7)){
-        FragColor.xyz = Kd;
-        return;
-    }
-
     float LN = max(dot(L,N), 0.0);
     float HN = max(dot(H,N), 0.0);
     float HL = max(dot(H,L), 0.0);
 
-    vec2 Nuv = vec2( 0.5 - atan(N.y,N.x)/(2*3.14159), acos(N.z)/3.14159 );
-    // vec3 NuvInverse = vec3( cos(2*3.14159*(.5-Nuv.x))*sin(3.14159*Nuv.y), sin(2*3.14159*(.5-Nuv.x))*sin(3.14159*Nuv.y), cos(3.14159*Nuv.y) );
 
     
     if (mode <= 2) {        // BRDF lighting
         bool inShadow  = false;
-        // vec4 shadowCoord = shadowMatrix * vec4(worldPos.x,worldPos.y,worldPos.z,1);
-        vec2 shadowIndex = shadowCoord.xy/shadowCoord.w;
-
-        vec4 b = texture2D(choleskyMap, shadowIndex);
-        float alpha = 0.000009;
-        vec4 bPrime = (1-alpha)*b + alpha*vec4(0.5, 0.5, 0.5, 0.5);
-
-        float zf = shadowCoord.w / 150.0;
-        float z1 = 1.0;
-        float z2 = zf;
-        float z3 = zf*zf;
-
-        float m11 = 1;
-        float m12 = bPrime.x;
-        float m13 = bPrime.y;
-        float m22 = bPrime.y;
-        float m23 = bPrime.z;
-        float m33 = bPrime.w;
-
-        vec3 Cs = cholesky(m11,m12,m13,m22,m23,m33, z1,z2,z3);
-
-        // (-b +- sqrt(b*b - 4*a*c)) / (2*a)
-        z2 = (-Cs.y - sqrt(Cs.y*Cs.y - 4*Cs.x*Cs.z)) / (2*Cs.z);
-        z3 = (-Cs.y + sqrt(Cs.y*Cs.y - 4*Cs.x*Cs.z)) / (2*Cs.z);
-
-        if(z2 > z3){
-            float tmp = z2;
-            z2 = z3;
-            z3 = z2;
-        }
+        vec3 shadowCoord = vec3(0.0);
+        int layer = receivesShadow ? Cascade(worldPos, shadowCoord) : -1;
+
+        float zf = shadowCoord.z;
+        vec4 b;
+        if (summedArea && layer >= 0) {
+            // Blockers cover a fraction Gb of the search box.  Were the
+            // rest at zf, the box's mean depth gives the blockers' mean
+            // depth (as variance soft shadow maps estimate it), and with
+            // it the penumbra's width.
+            ivec2 p = ivec2(shadowCoord.xy*vec2(textureSize(satMap, 0).xy));
+            vec4 search = BoxMoments(layer, p, searchRadius);
+            float Gb = MomentShadow(search, zf);
+            float zb = zf;
+            if (Gb > 0.01) {
+                float mean = (quantized ? DequantizeMoments(search) : search).x;
+                zb = clamp((mean - (1.0 - Gb)*zf)/Gb, 0.0, zf); }
+            int r = int(clamp(cascadePenumbra[layer]*(zf - zb), 1.0, float(maxRadius)));
+            b = BoxMoments(layer, p, r); }
+        else
+            b = texture(choleskyMap, vec3(shadowCoord.xy, max(layer, 0)));
+
+        float Gs = MomentShadow(b, zf);
 
-        float Gs = 0.0;
-        if(zf <= z2){
+        // Gs = texture2D(choleskyMap, shadowIndex).x;
+
+        if(layer < 0){          // Beyond the shadow distance
             Gs = 0.0;
         }
-        else if(zf <= z3){
-            Gs = (zf*z3 - bPrime.x*(zf+z3) + bPrime.y) / ((z3-z2)*(zf-z2));
-        }
-        else{
-            Gs = 1.0 - (z2*z3 - bPrime.x*(z2+z3) + bPrime.y) / ((zf-z2)*(zf-z3));
-        }
-
-        // Gs = texture2D(choleskyMap, shadowIndex).x;
 
         if(Gs > 0.01){
             inShadow = true;
@@ -171,9 +241,9 @@ void main()
         if(inShadow){
             FragColor.xyz = Ambient*Kd + (1-Gs)*Light*LN*(Kd/3.14159 + BRDF);
             if(reflective){
-                FragColor.xyz = Light*texture2D(skyIrr, Nuv).xyz*(Kd/3.14159) + (1-Gs)*Light*LN*(Kd/3.14159 + BRDF);
+                FragColor.xyz = Light*texture(skyIrr, N).xyz*(Kd/3.14159) + (1-Gs)*Light*LN*(Kd/3.14159 + BRDF);
                 if(mode == 2){
-                    FragColor.xyz = Light*texture2D(skyIrr2, Nuv).xyz*(Kd/3.14159) + (1-Gs)*Light*LN*(Kd/3.14159 + BRDF);
+                    FragColor.xyz = Light*texture(skyIrr2, N).xyz*(Kd/3.14159) + (1-Gs)*Light*LN*(Kd/3.14159 + BRDF);
                 }
             }
         }
@@ -197,10 +267,10 @@ void main()
 
                         pw += 1 / pow(dot(vec3(0,0,0), H), 2);
                     }
-                    FragColor.xyz = Light*texture2D(skyIrr, Nuv).xyz*(Kd/3.14159) + Light * LN * (Kd/3.14159 + BRDF);
+                    FragColor.xyz = Light*texture(skyIrr, N).xyz*(Kd/3.14159) + Light * LN * (Kd/3.14159 + BRDF);
                 }
                 else{
-                    FragColor.xyz = Light*texture2D(skyIrr2, Nuv).xyz*Kd/3.14159 + Light * LN * (Kd/3.14159 + BRDF);
+                    FragColor.xyz = Light*texture(skyIrr2, N).xyz*Kd/3.14159 + Light * LN * (Kd/3.14159 + BRDF);
                 }
             }
         }
@@ -6,18 +6,15 @@
 ////////////////////////////////////////////////////////////////////////
 #version 330
 
-uniform mat4 ModelTr, NormalTr, WorldProj,  WorldView, WorldInverse, ShadowMatrix;
+uniform mat4 ModelTr, NormalTr, WorldProj,  WorldView, WorldInverse;
 uniform vec3 lightPos, eyePos;
 
 in vec4 vertex;
 in vec3 vertexNormal;
 in vec2 vertexTexture;
-in vec3 vertexTangent;
-
-out vec4 shadowCoord;
+in vec4 vertexTangent;
 
 void main()
 {
 	gl_Position=WorldProj*WorldView*ModelTr*vertex;
-	shadowCoord = ShadowMatrix * ModelTr*vertex;
 }
@@ -12,6 +12,7 @@
 #include "math.h"
 #include <fstream>
 #include <stdlib.h>
+#include <algorithm>
 
 #include <glbinding/gl/gl.h>
 #include <glbinding/Binding.h>
@@ -29,133 +30,135 @@ using namespace gl;
 #define CHECKERROR {GLenum err = glGetError(); if (err != GL_NO_ERROR) { fprintf(stderr, "OpenGL error (at line object.cpp:%d): %s\n", __LINE__, gluErrorString(err)); exit(-1);} }
 
 
-Object::Object(Shape* _shape, const int _objectId,
-               const glm::vec3 _diffuseColor, const glm::vec3 _specularColor, const float _shininess, const bool _reflective)
-    : diffuseColor(_diffuseColor), specularColor(_specularColor), shininess(_shininess),
-      shape(_shape), objectId(_objectId), reflective(_reflective)
-     
+Object::Object(Shape* _shape, Material* _material)
+    : shape(_shape), material(_material), staticCaster(true),
+      castsShadow(true), receivesShadow(true)
 {}
 
 
 void Object::Draw(ShaderProgram* program, glm::mat4& objectTr)
 {
-    CHECKERROR;
-    // @@ The object specific parameters (uniform variables) used by
-    // the shader are set here.  Scene specific parameters are set in
-    // the DrawScene procedure in scene.cpp
-
-    // @@ Textures, being uniform sampler2d variables in the shader,
-    // are also set here.  Call texture->Bind in texture.cpp to do so.
-    
-    // Inform the shader of the surface values Kd, Ks, and alpha.
-    int loc = glGetUniformLocation(program->programId, "diffuse");
-    glUniform3fv(loc, 1, &diffuseColor[0]);
-    CHECKERROR;
-
-    loc = glGetUniformLocation(program->programId, "specular");
-    glUniform3fv(loc, 1, &specularColor[0]);
-
-    loc = glGetUniformLocation(program->programId, "shininess");
-    glUniform1f(loc, shininess);
-
-    // Inform the shader of which object is being drawn so it can make
-    // object specific decisions.
-    loc = glGetUniformLocation(program->programId, "objectId");
-    glUniform1i(loc, objectId);
-
-    CHECKERROR;
-    
-    // Inform the shader of this object's model transformation.  The
-    // inverse of the model transformation, needed for transforming
-    // normals, is calculated and passed to the shader here.
-    loc = glGetUniformLocation(program->programId, "ModelTr");
-    glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(objectTr));
-    
-    glm::mat4 inv = glm::inverse(objectTr);
-    loc = glGetUniformLocation(program->programId, "NormalTr");
-    glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(inv));
-
-    // If this object has an associated texture, this is the place to
-    // load the texture into a texture-unit of your choice and inform
-    // the shader program of the texture-unit number.  See
-    // Texture::Bind for the 4 lines of code to do exactly that.
-
-    loc = glGetUniformLocation(program->programId, "reflective");
-    glUniform1i(loc, reflective);
-    
-
-    // Draw this object
-    CHECKERROR;
-    if (shape)
-        shape->DrawVAO();
-    CHECKERROR;
+    DrawList list;
+    list.Build(this, objectTr);
+    list.Draw(program);
+}
 
+void Object::Collect(const glm::mat4& objectTr, std::vector<DrawItem>& items, bool isStatic)
+{
+    isStatic = isStatic && staticCaster;
+    if (shape) {
+        DrawItem item = { this, objectTr, isStatic };
+        items.push_back(item); }
 
-    // Recursivelyy draw each sub-objects, each with its own transformation.
+    // Recursively collect each sub-object, each with its own transformation.
     for (int i=0;  i<instances.size();  i++) {
         glm::mat4 itr = objectTr*instances[i].second*animTr;
-        instances[i].first->Draw(program, itr); }
-    
-    CHECKERROR;
+        instances[i].first->Collect(itr, items, isStatic); }
 }
 
-void Object::DrawNonreflective(ShaderProgram* program, glm::mat4& objectTr)
+// Sort order for DrawList::Build
+static bool DrawOrder(const DrawItem& a, const DrawItem& b)
 {
-    // @@ The object specific parameters (uniform variables) used by
-    // the shader are set here.  Scene specific parameters are set in
-    // the DrawScene procedure in scene.cpp
-    //if (reflective)
-    //    return;
-
-    // @@ Textures, being uniform sampler2d variables in the shader,
-    // are also set here.  Call texture->Bind in texture.cpp to do so.
-
-    // Inform the shader of the surface values Kd, Ks, and alpha.
-    int loc = glGetUniformLocation(program->programId, "diffuse");
-    glUniform3fv(loc, 1, &diffuseColor[0]);
-
-    loc = glGetUniformLocation(program->programId, "specular");
-    glUniform3fv(loc, 1, &specularColor[0]);
-
-    loc = glGetUniformLocation(program->programId, "shininess");
-    glUniform1f(loc, shininess);
-
-    // Inform the shader of which object is being drawn so it can make
-    // object specific decisions.
-    loc = glGetUniformLocation(program->programId, "objectId");
-    glUniform1i(loc, objectId);
-
-    // Inform the shader of this object's model transformation.  The
-    // inverse of the model transformation, needed for transforming
-    // normals, is calculated and passed to the shader here.
-    loc = glGetUniformLocation(program->programId, "ModelTr");
-    glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(objectTr));
-
-    glm::mat4 inv = glm::inverse(objectTr);
-    loc = glGetUniformLocation(program->programId, "NormalTr");
-    glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(inv));
+    if (a.object->shape->patches != b.object->shape->patches)
+        return !a.object->shape->patches;
+    int ma = a.object->material ? a.object->material->index : 0;
+    int mb = b.object->material ? b.object->material->index : 0;
+    if (ma != mb)
+        return ma < mb;
+    return a.object->shape < b.object->shape;
+}
 
-    // If this object has an associated texture, this is the place to
-    // load the texture into a texture-unit of your choice and inform
-    // the shader program of the texture-unit number.  See
-    // Texture::Bind for the 4 lines of code to do exactly that.
+static bool NoShadow(const DrawItem& item) { return !item.object->castsShadow; }
 
-    loc = glGetUniformLocation(program->programId, "reflective");
-    glUniform1i(loc, reflective);
+void DrawList::Build(Object* root, const glm::mat4& tr, const bool castersOnly)
+{
+    items.clear();
+    root->Collect(tr, items);
+    if (castersOnly)
+        items.erase(std::remove_if(items.begin(), items.end(), NoShadow), items.end());
+    std::stable_sort(items.begin(), items.end(), DrawOrder);
+}
 
+// Whether item's bounding box can reach into the orthographic volume
+// (see DrawList::Draw).  A shape without bounds (!bounded) can.
+static bool InVolume(const DrawItem& item, const glm::mat4& volume)
+{
+    Shape* shape = item.object->shape;
+    if (!shape->bounded)
+        return true;
+
+    glm::mat4 M = volume*item.tr;
+    glm::vec3 lo(1e30f), hi(-1e30f);
+    for (int k=0;  k<8;  k++) {
+        glm::vec3 P(k&1 ? shape->maxP.x : shape->minP.x,
+                    k&2 ? shape->maxP.y : shape->minP.y,
+                    k&4 ? shape->maxP.z : shape->minP.z);
+        glm::vec3 Q = glm::vec3(M*glm::vec4(P, 1.0f));
+        lo = glm::min(lo, Q);
+        hi = glm::max(hi, Q); }
+    return hi.x >= -1.0f && lo.x <= 1.0f && hi.y >= -1.0f && lo.y <= 1.0f && lo.z <= 1.0f;
+}
 
-    // Draw this object
-    CHECKERROR;
-    if (shape && !reflective)
-        shape->DrawVAO();
+int DrawList::Draw(ShaderProgram* program, const DrawSubset subset, const glm::mat4* volume)
+{
     CHECKERROR;
+    // @@ The object specific parameters (uniform variables) used by
+    // the shader are set here.  Scene specific parameters are set in
+    // the DrawScene procedure in scene.cpp
 
-
-    // Recursivelyy draw each sub-objects, each with its own transformation.
-    for (int i = 0; i < instances.size(); i++) {
-        glm::mat4 itr = objectTr * instances[i].second * animTr;
-        instances[i].first->DrawNonreflective(program, itr);
-    }
-
+    ShaderProgram* current = program;
+    int programId = program->programId;
+    int material = -1;          // None sent yet to current
+    int receives = -1;
+    int count = 0;
+    for (size_t i=0;  i<items.size();  i++) {
+        Object* ob = items[i].object;
+        if (subset != DRAW_ALL && items[i].staticCaster != (subset == DRAW_STATIC))
+            continue;
+        if (volume && !InVolume(items[i], *volume))
+            continue;
+
+        // A shape made of patches is drawn with the pass's companion
+        // patch program, set up with the same uniforms as this one.
+        // Without one, this pass skips it.
+        ShaderProgram* drawProgram = ob->shape->patches ? program->patchProgram : program;
+        if (!drawProgram)
+            continue;
+        if (drawProgram != current) {
+            drawProgram->Use();
+            if (drawProgram != program)
+                program->CopyUniforms(drawProgram);
+            current = drawProgram;
+            programId = drawProgram->programId;
+            material = receives = -1; }
+
+        // Inform the shader of which material to draw with;  the
+        // material table holds everything about it.
+        int index = ob->material ? ob->material->index : 0;
+        if (index != material) {
+            int loc = glGetUniformLocation(programId, "material");
+            glUniform1i(loc, index);
+            material = index; }
+        if ((int)ob->receivesShadow != receives) {
+            int loc = glGetUniformLocation(programId, "receivesShadow");
+            glUniform1i(loc, ob->receivesShadow);
+            receives = ob->receivesShadow; }
+
+        // Inform the shader of this object's model transformation.  The
+        // inverse of the model transformation, needed for transforming
+        // normals, is calculated and passed to the shader here.
+        int loc = glGetUniformLocation(programId, "ModelTr");
+        glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(items[i].tr));
+
+        glm::mat4 inv = glm::inverse(items[i].tr);
+        loc = glGetUniformLocation(programId, "NormalTr");
+        glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(inv));
+
+        ob->shape->DrawVAO(drawProgram->positionsOnly);
+        count++; }
+
+    if (current != program)
+        program->Use();
     CHECKERROR;
+    return count;
 }
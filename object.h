@@ -8,12 +8,17 @@
 //
 // Methods consist of a constructor, and a Draw procedure, and an
 // append for building hierarchies of objects.
+//
+// A DrawList flattens a hierarchy into a list of objects and their
+// full transformations, sorted so that objects sharing a material,
+// and then a shape, are drawn one after another.
 
 #ifndef _OBJECT
 #define _OBJECT
 
 #include "shapes.h"
 #include "texture.h"
+#include "materialtable.h"
 #include <utility>              // for pair<Object*,glm::mat4>
 
 class Shader;
@@ -21,33 +26,73 @@ class Object;
 
 typedef std::pair<Object*,glm::mat4> INSTANCE;
 
-// Object:: A shape, and its transformations, colors, and textures and sub-objects.
+// One object to draw, with its full modeling transformation
+struct DrawItem
+{
+    Object* object;
+    glm::mat4 tr;
+    bool staticCaster;          // Neither it nor any parent moves
+};
+
+// Which of a DrawList's items to draw
+enum DrawSubset { DRAW_ALL, DRAW_STATIC, DRAW_DYNAMIC };
+
+// Written to the G-buffer with the material flags (see gbuff.frag),
+// for an object that receives no shadows.  Beyond MaterialFlags.
+const int OBJ_NO_SHADOW = 256;
+
+// Object:: A shape, and its transformations, material and sub-objects.
 class Object
 {
  public:
     Shape* shape;               // Polygons 
     glm::mat4 animTr;                // This model's animation transformation
-    int objectId;               // Object id to be sent to the shader
+    Material* material;         // Surface;  NULL for the table's plain entry 0
+
+    // False for an object that moves (animTr changes, say).  Its
+    // sub-objects move with it, so their shadows cannot be cached.
+    bool staticCaster;
 
-    glm::vec3 diffuseColor;          // Diffuse color of object
-    glm::vec3 specularColor;         // Specular color of object
-    float shininess;            // Surface roughness value
-    bool reflective;
+    // Whether it is drawn into the shadow maps, and whether shadows
+    // fall on it.  Neither is inherited by sub-objects.
+    bool castsShadow, receivesShadow;
 
     std::vector<INSTANCE> instances; // Pairs of sub-objects and transformations 
 
-    Object(Shape* _shape, const int objectId,
-           const glm::vec3 _d=glm::vec3(), const glm::vec3 _s=glm::vec3(), const float _n=1, const bool _reflective=false);
+    Object(Shape* _shape, Material* _material=NULL);
 
-    // If this object is to be drawn with a texture, this is a good
-    // place to store the texture id (a small positive integer).  The
-    // texture id should be set in Scene::InitializeScene and used in
-    // Object::Draw.
-    
+    // Draw this object and its sub-objects (through a DrawList).
     void Draw(ShaderProgram* program, glm::mat4& objectTr);
-    void DrawNonreflective(ShaderProgram* program, glm::mat4& objectTr);
+
+    // Append this object and its sub-objects, those with shapes, to
+    // items.  Static is false under a parent that moves.
+    void Collect(const glm::mat4& objectTr, std::vector<DrawItem>& items, bool isStatic=true);
 
     void add(Object* m, glm::mat4 tr=glm::mat4()) { instances.push_back(std::make_pair(m,tr)); }
 };
 
+class DrawList
+{
+ public:
+    std::vector<DrawItem> items;
+
+    // Flatten root's hierarchy (as placed by tr) and sort it:  plain
+    // shapes before patches (which switch programs), then by material,
+    // then by shape.  With castersOnly, objects that cast no shadows
+    // are left out.
+    void Build(Object* root, const glm::mat4& tr, const bool castersOnly=false);
+
+    // Draw every item, or only the static or moving ones, and return
+    // how many were drawn.  The material index is sent to the shader
+    // only when it changes.
+    //
+    // With volume, an orthographic projection, items whose bounds lie
+    // wholly outside its x or y range, or beyond its far plane, are
+    // skipped.  Those in front of its near plane are kept:  a caster
+    // between the light and a shadow cascade still casts into it
+    // (flattened onto the near plane by GL_DEPTH_CLAMP).
+    int Draw(ShaderProgram* program, const DrawSubset subset=DRAW_ALL,
+             const glm::mat4* volume=NULL);
+};
+
 #endif
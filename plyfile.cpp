@@ -0,0 +1,512 @@
+///////////////////////////////////////////////////////////////////////
+// A reader for PLY files (ascii, binary_little_endian and
+// binary_big_endian).  The header is parsed first, the Shape's arrays
+// are sized from its element counts, and the body is then decoded
+// straight from a memory mapping of the file into those arrays.
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "shapes.h"
+#include "plyfile.h"
+#include "mappedfile.h"
+
+enum PlyType { PLY_NONE, PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16,
+               PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64 };
+static const int PlySize[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+enum PlyFormat { PLY_ASCII, PLY_BINARY_LE, PLY_BINARY_BE };
+
+struct PlyProperty
+{
+    std::string name;
+    PlyType type;               // Scalar type, or type of the list items
+    PlyType countType;          // PLY_NONE for a scalar, else type of the list length
+};
+
+struct PlyElement
+{
+    std::string name;
+    size_t count;
+    std::vector<PlyProperty> props;
+};
+
+struct PlyHeader
+{
+    PlyFormat format;
+    std::vector<PlyElement> elements;
+    size_t body;                // Offset of the first byte after end_header
+};
+
+// Where the value of one vertex property is stored:  base[i*stride]
+// for vertex i, or nowhere if base is NULL.
+struct PlySlot
+{
+    float* base;
+    int stride;
+};
+
+static PlyType ParseType(const std::string& s)
+{
+    if (s == "char"   || s == "int8")    return PLY_INT8;
+    if (s == "uchar"  || s == "uint8")   return PLY_UINT8;
+    if (s == "short"  || s == "int16")   return PLY_INT16;
+    if (s == "ushort" || s == "uint16")  return PLY_UINT16;
+    if (s == "int"    || s == "int32")   return PLY_INT32;
+    if (s == "uint"   || s == "uint32")  return PLY_UINT32;
+    if (s == "float"  || s == "float32") return PLY_FLOAT32;
+    if (s == "double" || s == "float64") return PLY_FLOAT64;
+    return PLY_NONE;
+}
+
+// Parse the header at the start of data.  Returns false if it is not
+// a well formed PLY header.
+static bool ReadHeader(const char* data, size_t size, PlyHeader& h)
+{
+    const char* p = data;
+    const char* end = data + size;
+    bool first = true;
+
+    while (p < end) {
+        const char* eol = (const char*)memchr(p, '\n', end-p);
+        if (!eol) return false;
+        std::string line(p, eol);
+        p = eol+1;
+        if (!line.empty() && line[line.size()-1] == '\r')
+            line.erase(line.size()-1);
+
+        std::istringstream in(line);
+        std::string word;
+        in >> word;
+
+        if (first) {
+            if (word != "ply") return false;
+            first = false; }
+
+        else if (word == "format") {
+            std::string fmt;
+            in >> fmt;
+            if (fmt == "ascii")                     h.format = PLY_ASCII;
+            else if (fmt == "binary_little_endian") h.format = PLY_BINARY_LE;
+            else if (fmt == "binary_big_endian")    h.format = PLY_BINARY_BE;
+            else return false; }
+
+        else if (word == "element") {
+            PlyElement e;
+            in >> e.name >> e.count;
+            if (in.fail()) return false;
+            h.elements.push_back(e); }
+
+        else if (word == "property") {
+            if (h.elements.empty()) return false;
+            PlyProperty prop;
+            std::string type;
+            in >> type;
+            if (type == "list") {
+                std::string countType, itemType;
+                in >> countType >> itemType;
+                prop.countType = ParseType(countType);
+                prop.type = ParseType(itemType);
+                if (prop.countType == PLY_NONE) return false; }
+            else {
+                prop.countType = PLY_NONE;
+                prop.type = ParseType(type); }
+            in >> prop.name;
+            if (prop.type == PLY_NONE || in.fail()) return false;
+            h.elements.back().props.push_back(prop); }
+
+        else if (word == "end_header") {
+            h.body = p - data;
+            return true; } }
+
+    return false;
+}
+
+// Size shape's arrays for element e (the vertices), and return the
+// destination of each of its properties.
+static void VertexSlots(const PlyElement& e, Shape* shape, std::vector<PlySlot>& slots)
+{
+    bool hasNrm = false, hasTex = false;
+    for (size_t k=0;  k<e.props.size();  k++) {
+        const std::string& n = e.props[k].name;
+        if (n == "nx" || n == "ny" || n == "nz") hasNrm = true;
+        if (n == "s" || n == "t" || n == "u" || n == "v"
+            || n == "texture_u" || n == "texture_v") hasTex = true; }
+
+    shape->Pnt.assign(e.count, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    if (hasNrm) shape->Nrm.assign(e.count, glm::vec3(0.0f));
+    if (hasTex) shape->Tex.assign(e.count, glm::vec2(0.0f));
+
+    float* P = e.count ? &shape->Pnt[0][0] : NULL;
+    float* N = hasNrm && e.count ? &shape->Nrm[0][0] : NULL;
+    float* T = hasTex && e.count ? &shape->Tex[0][0] : NULL;
+
+    slots.resize(e.props.size());
+    for (size_t k=0;  k<e.props.size();  k++) {
+        const std::string& n = e.props[k].name;
+        PlySlot& s = slots[k];
+        s.base = NULL;
+        s.stride = 0;
+        if (e.props[k].countType != PLY_NONE) continue;
+        if      (n == "x")  { s.base = P;   s.stride = 4; }
+        else if (n == "y")  { s.base = P+1; s.stride = 4; }
+        else if (n == "z")  { s.base = P+2; s.stride = 4; }
+        else if (n == "nx") { s.base = N;   s.stride = 3; }
+        else if (n == "ny") { s.base = N+1; s.stride = 3; }
+        else if (n == "nz") { s.base = N+2; s.stride = 3; }
+        else if (n == "s" || n == "u" || n == "texture_u") { s.base = T;   s.stride = 2; }
+        else if (n == "t" || n == "v" || n == "texture_v") { s.base = T+1; s.stride = 2; } }
+}
+
+// Index of the face property holding the vertex list, or -1.
+static int FaceList(const PlyElement& e)
+{
+    for (size_t k=0;  k<e.props.size();  k++)
+        if (e.props[k].countType != PLY_NONE
+            && (e.props[k].name == "vertex_indices" || e.props[k].name == "vertex_index"))
+            return k;
+    return -1;
+}
+
+// Split a polygon into a fan of triangles, as (0,1,2), (0,2,3), ...
+static void PushFan(std::vector<glm::ivec3>& Tri, const int* v, const int n)
+{
+    for (int k=2;  k<n;  k++)
+        Tri.push_back(glm::ivec3(v[0], v[k-1], v[k]));
+}
+
+////////////////////////////////////////////////////////////////////////
+// Binary bodies
+
+// Decode one binary scalar of type t at p, byte swapping if needed.
+static inline double GetBinary(const char* p, const PlyType t, const bool swap)
+{
+    char b[8];
+    const int n = PlySize[t];
+    if (swap)
+        for (int i=0;  i<n;  i++) b[i] = p[n-1-i];
+    else
+        memcpy(b, p, n);
+
+    switch (t) {
+    case PLY_INT8:    { signed char v;    memcpy(&v, b, 1);  return v; }
+    case PLY_UINT8:   { unsigned char v;  memcpy(&v, b, 1);  return v; }
+    case PLY_INT16:   { short v;          memcpy(&v, b, 2);  return v; }
+    case PLY_UINT16:  { unsigned short v; memcpy(&v, b, 2);  return v; }
+    case PLY_INT32:   { int v;            memcpy(&v, b, 4);  return v; }
+    case PLY_UINT32:  { unsigned int v;   memcpy(&v, b, 4);  return v; }
+    case PLY_FLOAT32: { float v;          memcpy(&v, b, 4);  return v; }
+    case PLY_FLOAT64: { double v;         memcpy(&v, b, 8);  return v; }
+    default: return 0.0; }
+}
+
+static bool ReadBinaryBody(const PlyHeader& h, const char* p, const char* end, Shape* shape)
+{
+    unsigned int one = 1;
+    bool littleHost = *(unsigned char*)&one == 1;
+    bool swap = littleHost != (h.format == PLY_BINARY_LE);
+    std::vector<int> poly;
+
+    for (size_t el=0;  el<h.elements.size();  el++) {
+        const PlyElement& e = h.elements[el];
+        bool isVertex = e.name == "vertex";
+        bool isFace = e.name == "face";
+
+        std::vector<PlySlot> slots;
+        if (isVertex)
+            VertexSlots(e, shape, slots);
+        int list = isFace ? FaceList(e) : -1;
+        if (isFace)
+            shape->Tri.reserve(e.count);
+
+        // The common case of vertices made only of floats in host byte
+        // order is a straight copy.
+        bool allFloat = isVertex && !swap;
+        for (size_t k=0;  k<e.props.size();  k++)
+            if (e.props[k].countType != PLY_NONE || e.props[k].type != PLY_FLOAT32)
+                allFloat = false;
+        if (allFloat) {
+            size_t stride = 4*e.props.size();
+            if ((size_t)(end-p) < e.count*stride) return false;
+            for (size_t k=0;  k<e.props.size();  k++)
+                if (slots[k].base)
+                    for (size_t i=0;  i<e.count;  i++)
+                        memcpy(&slots[k].base[i*slots[k].stride], p + i*stride + 4*k, 4);
+            p += e.count*stride;
+            continue; }
+
+        for (size_t i=0;  i<e.count;  i++) {
+            for (size_t k=0;  k<e.props.size();  k++) {
+                const PlyProperty& prop = e.props[k];
+                int size = PlySize[prop.type];
+
+                if (prop.countType == PLY_NONE) {
+                    if (p + size > end) return false;
+                    if (isVertex && slots[k].base)
+                        slots[k].base[i*slots[k].stride] = (float)GetBinary(p, prop.type, swap);
+                    p += size;
+                    continue; }
+
+                if (p + PlySize[prop.countType] > end) return false;
+                int n = (int)GetBinary(p, prop.countType, swap);
+                p += PlySize[prop.countType];
+                if (n < 0 || p + (size_t)n*size > end) return false;
+
+                if ((int)k == list) {
+                    // Scans are usually all triangles or all quads, so
+                    // the first face is a good guess at the total.
+                    if (i == 0 && n > 3)
+                        shape->Tri.reserve(e.count*(n-2));
+                    poly.resize(n);
+                    for (int j=0;  j<n;  j++, p += size)
+                        poly[j] = (int)GetBinary(p, prop.type, swap);
+                    PushFan(shape->Tri, poly.data(), n); }
+                else
+                    p += n*size; } } }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// ASCII bodies
+
+static inline bool IsSpace(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static const double Pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+// Parse the number at p (after any white space) into v without reading
+// past end, and return the first character not used, or NULL if there
+// is no number.  A decimal with at most 15 significant digits and an
+// exponent within +-22 is exactly m*10^e or m/10^e in double arithmetic
+// (Clinger's fast path), which covers what exporters write and ignores
+// the C locale.  Anything else is handed to strtod, so the result
+// always equals strtod's.
+static const char* ParseNumber(const char* p, const char* end, double& v)
+{
+    while (p < end && IsSpace(*p)) p++;
+    const char* token = p;
+
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        neg = *p++ == '-';
+
+    unsigned long long m = 0;
+    int digits = 0, exp10 = 0;
+    bool any = false;
+    for (;  p < end && *p >= '0' && *p <= '9';  p++) {
+        any = true;
+        if (m || *p != '0') digits++;
+        if (digits <= 19) m = m*10 + (*p - '0');
+        else exp10++; }
+    if (p < end && *p == '.')
+        for (p++;  p < end && *p >= '0' && *p <= '9';  p++) {
+            any = true;
+            if (m || *p != '0') digits++;
+            if (digits <= 19) { m = m*10 + (*p - '0');  exp10--; } }
+    if (any && p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p+1;
+        bool eneg = false;
+        if (q < end && (*q == '-' || *q == '+'))
+            eneg = *q++ == '-';
+        if (q < end && *q >= '0' && *q <= '9') {
+            int e = 0;
+            for (;  q < end && *q >= '0' && *q <= '9';  q++)
+                if (e < 100000) e = e*10 + (*q - '0');
+            exp10 += eneg ? -e : e;
+            p = q; } }
+
+    if (any && digits <= 15 && exp10 >= -22 && exp10 <= 22 && (p == end || IsSpace(*p))) {
+        double d = (double)m;
+        d = exp10 < 0 ? d/Pow10[-exp10] : d*Pow10[exp10];
+        v = neg ? -d : d;
+        return p; }
+
+    // strtod needs a terminated string, which the mapping is not.
+    const char* stop = token;
+    while (stop < end && !IsSpace(*stop)) stop++;
+    std::string s(token, stop);
+    char* q;
+    v = strtod(s.c_str(), &q);
+    if (q == s.c_str()) return NULL;
+    return token + (q - s.c_str());
+}
+
+// Parse instances first .. first+count-1 of element e from [p, end).
+// Scalars go to slots (if any), and the vertex list named by list is
+// triangulated into Tri.  Returns the end of the last value read, or
+// NULL if the text runs out or is not a number.
+static const char* ParseAsciiRange(const PlyElement& e, const std::vector<PlySlot>& slots,
+                                   const int list, const size_t first, const size_t count,
+                                   const char* p, const char* end, std::vector<glm::ivec3>& Tri)
+{
+    std::vector<int> poly;
+    double v;
+
+    for (size_t i=first;  i<first+count;  i++) {
+        for (size_t k=0;  k<e.props.size();  k++) {
+            if (e.props[k].countType == PLY_NONE) {
+                if (!(p = ParseNumber(p, end, v))) return NULL;
+                if (!slots.empty() && slots[k].base)
+                    slots[k].base[i*slots[k].stride] = (float)v;
+                continue; }
+
+            if (!(p = ParseNumber(p, end, v))) return NULL;
+            int n = (int)v;
+            if (n < 0) return NULL;
+            poly.resize(n);
+            for (int j=0;  j<n;  j++) {
+                if (!(p = ParseNumber(p, end, v))) return NULL;
+                poly[j] = (int)v; }
+            if ((int)k == list) {
+                if (i == first && n > 3)
+                    Tri.reserve(count*(n-2));
+                PushFan(Tri, poly.data(), n); } } }
+    return p;
+}
+
+// Elements with fewer lines than this per thread are not worth splitting.
+static const size_t AsciiChunkLines = 16384;
+
+static void ParseAsciiChunk(const PlyElement* e, const std::vector<PlySlot>* slots, int list,
+                            size_t first, size_t count, const char* p, const char* end,
+                            std::vector<glm::ivec3>* Tri, const char** result)
+{
+    *result = ParseAsciiRange(*e, *slots, list, first, count, p, end, *Tri);
+}
+
+// Read element e starting at p, and return the end of its last value.
+// Exporters write one instance per line, so a large element is cut
+// into runs of whole lines that are parsed on separate threads.  Each
+// run must consume exactly its lines; if any does not (an instance
+// spread over several lines) the element is reparsed serially.  Faces
+// from each run are appended to Tri in order, so the result does not
+// depend on the number of threads.
+static const char* ReadAsciiElement(const PlyElement& e, const char* p, const char* end, Shape* shape)
+{
+    std::vector<PlySlot> slots;
+    if (e.name == "vertex")
+        VertexSlots(e, shape, slots);
+    int list = e.name == "face" ? FaceList(e) : -1;
+    std::vector<glm::ivec3> skipped;
+    std::vector<glm::ivec3>& Tri = e.name == "face" ? shape->Tri : skipped;
+
+    size_t threads = std::thread::hardware_concurrency();
+    threads = std::min(threads, e.count/AsciiChunkLines);
+    if (threads < 2) {
+        Tri.reserve(e.count);
+        return ParseAsciiRange(e, slots, list, 0, e.count, p, end, Tri); }
+
+    // Find where each run of lines starts.
+    while (p < end && IsSpace(*p)) p++;
+    size_t lines = (e.count + threads-1)/threads;
+    std::vector<const char*> start(threads+1, (const char*)NULL);
+    start[0] = p;
+    const char* q = p;
+    for (size_t c=0;  c<threads && q;  c++) {
+        size_t n = std::min(lines, e.count - c*lines);
+        for (size_t j=0;  j<n && q;  j++) {
+            q = (const char*)memchr(q, '\n', end-q);
+            if (q) q++; }
+        // The last line of the file need not end in a newline.
+        if (!q && c == threads-1) q = end;
+        start[c+1] = q; }
+
+    bool ok = start[threads] != NULL;
+    if (ok) {
+        std::vector<std::vector<glm::ivec3> > tris(threads);
+        std::vector<const char*> result(threads, (const char*)NULL);
+        std::vector<std::thread> workers;
+        for (size_t c=1;  c<threads;  c++)
+            workers.push_back(std::thread(ParseAsciiChunk, &e, &slots, list, c*lines,
+                                          std::min(lines, e.count - c*lines),
+                                          start[c], start[c+1], &tris[c], &result[c]));
+        ParseAsciiChunk(&e, &slots, list, 0, lines, start[0], start[1], &tris[0], &result[0]);
+        for (size_t c=0;  c<workers.size();  c++)
+            workers[c].join();
+
+        for (size_t c=0;  c<threads && ok;  c++) {
+            ok = result[c] != NULL;
+            for (const char* r=result[c];  ok && r<start[c+1];  r++)
+                ok = IsSpace(*r); }
+
+        if (ok) {
+            size_t total = 0;
+            for (size_t c=0;  c<threads;  c++)
+                total += tris[c].size();
+            Tri.reserve(total);
+            for (size_t c=0;  c<threads;  c++)
+                Tri.insert(Tri.end(), tris[c].begin(), tris[c].end());
+            return result[threads-1]; } }
+
+    Tri.clear();
+    Tri.reserve(e.count);
+    return ParseAsciiRange(e, slots, list, 0, e.count, p, end, Tri);
+}
+
+// Whether every face index names one of the vertices read.  A
+// malformed or truncated file can hold anything there.
+static bool IndicesInRange(const Shape* shape)
+{
+    int n = (int)shape->Pnt.size();
+    for (size_t i=0;  i<shape->Tri.size();  i++)
+        for (int c=0;  c<3;  c++)
+            if (shape->Tri[i][c] < 0 || shape->Tri[i][c] >= n)
+                return false;
+    return true;
+}
+
+static bool ReadAsciiBody(const PlyHeader& h, const char* p, const char* end, Shape* shape)
+{
+    for (size_t el=0;  el<h.elements.size();  el++)
+        if (!(p = ReadAsciiElement(h.elements[el], p, end, shape)))
+            return false;
+    return true;
+}
+
+bool ReadPly(const char* name, Shape* shape)
+{
+    MappedFile file;
+    if (!file.Open(name)) {
+        printf("Cannot open PLY file %s\n", name);
+        return false; }
+
+    PlyHeader h;
+    if (!ReadHeader(file.data, file.size, h)) {
+        printf("Bad PLY header in %s\n", name);
+        return false; }
+
+    shape->Pnt.clear();
+    shape->Nrm.clear();
+    shape->Tex.clear();
+    shape->Tri.clear();
+
+    const char* body = file.data + h.body;
+    const char* end = file.data + file.size;
+    bool ok = h.format == PLY_ASCII
+        ? ReadAsciiBody(h, body, end, shape)
+        : ReadBinaryBody(h, body, end, shape);
+    if (!ok) {
+        printf("Truncated or malformed PLY body in %s\n", name);
+        return false; }
+    if (!IndicesInRange(shape)) {
+        printf("PLY face index beyond the %ld vertices in %s\n", shape->Pnt.size(), name);
+        return false; }
+
+    printf("ReadPly %s: %ld vertices %ld triangles\n", name, shape->Pnt.size(), shape->Tri.size());
+    return true;
+}
@@ -0,0 +1,20 @@
+///////////////////////////////////////////////////////////////////////
+// A reader for PLY files (ascii, binary_little_endian and
+// binary_big_endian).  The header is parsed first, the Shape's arrays
+// are sized from its element counts, and the body is then decoded
+// straight from a memory mapping of the file into those arrays.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _PLYFILE_
+#define _PLYFILE_
+
+class Shape;
+
+// Fill shape's Pnt, Nrm, Tex and Tri arrays from the vertex and face
+// elements of the named PLY file.  Vertex properties x,y,z go to Pnt,
+// nx,ny,nz to Nrm, and s,t (or u,v) to Tex;  faces with more than
+// three vertices are split into a fan of triangles.  Returns false
+// (after printing the reason) if the file cannot be read.
+bool ReadPly(const char* name, Shape* shape);
+
+#endif
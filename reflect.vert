@@ -7,7 +7,6 @@
 
 uniform mat4 WorldView, WorldInverse, WorldProj, ModelTr, NormalTr;
 // uniform mat4 View, Proj, ModelTr;
-uniform bool reflective;
 uniform float S;
 
 in vec4 vertex;
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////
+// Shared resources (see resources.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+
+#include <glbinding/gl/gl.h>
+#include <glbinding/Binding.h>
+using namespace gl;
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "shapes.h"
+#include "texture.h"
+#include "resources.h"
+
+ShaderProgram* Resources::ComputeProgram(const char* file, const char* prelude)
+{
+    ShaderProgram* program = programs.Acquire(file);
+    if (program)
+        return program;
+
+    program = new ShaderProgram();
+    program->AddShader(file, GL_COMPUTE_SHADER, prelude);
+    program->LinkProgram();
+    return programs.Add(file, program);
+}
+
+int Resources::Evict()
+{
+    return textures.Evict() + programs.Evict() + shapes.Evict();
+}
+
+void Resources::Report() const
+{
+    textures.Report();
+    programs.Report();
+    shapes.Report();
+    printf("Resident: %.2f MB\n",
+           (textures.Bytes() + programs.Bytes() + shapes.Bytes())/(1024.0*1024.0));
+}
@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////
+// Shared resources:  textures, shader programs and shapes, each made
+// once for a given file and parameters and handed to everyone who
+// asks for the same thing.  Every resource carries a count of its
+// holders;  Acquire and Get add one, Release drops one, and Evict
+// deletes whatever nobody holds.  Report prints how much of each type
+// is resident.
+//
+// A resource type T must have a virtual or plain destructor that frees
+// its OpenGL objects, and a method
+//    size_t Bytes() const
+// giving the memory it occupies on the graphics card.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _RESOURCES_
+#define _RESOURCES_
+
+#include <stdio.h>
+#include <string>
+#include <map>
+
+class Texture;
+class ShaderProgram;
+class Shape;
+
+template<class T> class ResourceCache
+{
+ public:
+    const char* kind;           // For Report
+
+    ResourceCache(const char* _kind) : kind(_kind) {}
+
+    // The resource made under key, now held once more, or NULL.
+    T* Acquire(const std::string& key)
+    {
+        typename std::map<std::string, Entry>::iterator found = entries.find(key);
+        if (found == entries.end()) return NULL;
+        found->second.refs++;
+        return found->second.resource;
+    }
+
+    // Enter a newly made resource under key, held once by the caller.
+    T* Add(const std::string& key, T* resource)
+    {
+        Entry& e = entries[key];
+        e.resource = resource;
+        e.refs = 1;
+        return resource;
+    }
+
+    // Acquire key, or if it is not there, Add make().
+    template<class F> T* Get(const std::string& key, F make)
+    {
+        T* resource = Acquire(key);
+        return resource ? resource : Add(key, make());
+    }
+
+    // Give up one hold on a resource.  It stays until Evict.
+    void Release(T* resource)
+    {
+        typename std::map<std::string, Entry>::iterator e;
+        for (e=entries.begin();  e!=entries.end();  e++)
+            if (e->second.resource == resource) {
+                if (e->second.refs > 0) e->second.refs--;
+                return; }
+    }
+
+    // Delete every resource that nobody holds.  Returns how many went.
+    int Evict()
+    {
+        int n = 0;
+        typename std::map<std::string, Entry>::iterator e = entries.begin();
+        while (e != entries.end()) {
+            if (e->second.refs > 0) {
+                e++;
+                continue; }
+            delete e->second.resource;
+            entries.erase(e++);
+            n++; }
+        return n;
+    }
+
+    size_t Count() const { return entries.size(); }
+
+    size_t Bytes() const
+    {
+        size_t total = 0;
+        typename std::map<std::string, Entry>::const_iterator e;
+        for (e=entries.begin();  e!=entries.end();  e++)
+            total += e->second.resource->Bytes();
+        return total;
+    }
+
+    // One line per resource, then the total.
+    void Report() const
+    {
+        typename std::map<std::string, Entry>::const_iterator e;
+        for (e=entries.begin();  e!=entries.end();  e++)
+            printf("  %9.1f KB  %2d held  %s\n", e->second.resource->Bytes()/1024.0,
+                   e->second.refs, e->first.c_str());
+        printf("%s: %d, %.2f MB\n", kind, (int)Count(), Bytes()/(1024.0*1024.0));
+    }
+
+ private:
+    struct Entry
+    {
+        T* resource;
+        int refs;
+    };
+    std::map<std::string, Entry> entries;
+
+    ResourceCache(const ResourceCache&);
+    ResourceCache& operator=(const ResourceCache&);
+};
+
+class Resources
+{
+ public:
+    ResourceCache<Texture> textures;
+    ResourceCache<ShaderProgram> programs;
+    ResourceCache<Shape> shapes;
+
+    Resources() : textures("Textures"), programs("Shader programs"), shapes("Shapes") {}
+
+    // The compute shader program of one file, held once more (built
+    // the first time, with prelude as ShaderProgram::AddShader takes
+    // it).  A file is always built with the same prelude.
+    ShaderProgram* ComputeProgram(const char* file, const char* prelude=NULL);
+
+    // Evict from every cache;  returns the number deleted.
+    int Evict();
+
+    // Resident memory per type, and in all.
+    void Report() const;
+};
+
+#endif
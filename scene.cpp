@@ -15,6 +15,15 @@
 #define REFL
 
 const bool fullPolyCount = true; // Use false when emulating the graphics pipeline in software
+const int shadowSize = 2048;      // Texels on a side of each cascade's layer
+const int shadowCascades = 3;     // Up to MaxCascades
+const int cascadeSize[] = {2048, 2048, 1536, 1024}; // Texels used of each layer, near to far
+const int shadowBlur = 10;        // Taps each side of the moments' blur, up to MaxFilterRadius
+const bool summedAreaShadows = true; // Box filter moments per pixel out of a summed-area table, as wide as the penumbra, rather than blur them
+const int shadowSearch = 16;      // Texels each side searched for blockers (summedAreaShadows)
+const float lightAngle = 0.02;    // Radians the light spans, for penumbra widths (summedAreaShadows)
+const bool cacheShadows = true;   // Keep static casters' shadows from frame to frame (see shadowcache.h)
+const bool quantizeShadows = true; // 16 bit optimized moments (8 bytes a texel) rather than 32 bit floats (16)
 #ifdef REFL
 const bool showSpheres = true;  // Use true for shadows and reflections test scenes
 #else
@@ -40,7 +49,9 @@ using namespace gl;
 #include "shapes.h"
 #include "object.h"
 #include "texture.h"
+#include "materialtable.h"
 #include "transform.h"
+#include "moments.h"
 // #include "scene.h"
 
 const float PI = 3.14159f;
@@ -48,6 +59,18 @@ const float rad = PI/180.0f;    // Convert degrees to radians
 
 glm::mat4 Identity;
 
+// The teapot is tessellated on the GPU when tessellation shaders are
+// available.  Use false to force the CPU-evaluated teapot.
+const bool tessellateTeapot = true;
+const float tessPixels = 8.0;   // Target on-screen length of a tessellated edge segment
+const float tessMaxLevel = 64.0; // Largest tessellation level (GL guarantees at least 64)
+const int tessBindpoint = 2;    // Uniform block binding for TessBlock (see teapot.tesc)
+
+struct {
+    glm::mat4 viewProj;
+    glm::vec4 params;
+} tessBlock;
+
 const float grndSize = 100.0;    // Island radius;  Minimum about 20;  Maximum 1000 or so
 const float grndOctaves = 4.0;  // Number of levels of detail to compute
 const float grndFreq = 0.03;    // Number of hills per (approx) 50m
@@ -90,16 +113,16 @@ glm::vec3 HSV2RGB(const float h, const float s, const float v)
 
 ////////////////////////////////////////////////////////////////////////
 // Constructs a hemisphere of spheres of varying hues
-Object* SphereOfSpheres(Shape* SpherePolygons)
+Object* SphereOfSpheres(Shape* SpherePolygons, MaterialTable* materials)
 {
-    Object* ob = new Object(NULL, nullId);
+    Object* ob = new Object(NULL);
     
     for (float angle=0.0;  angle<360.0;  angle+= 18.0)
         for (float row=0.075;  row<PI/2.0;  row += PI/2.0/6.0) {   
             glm::vec3 hue = HSV2RGB(angle/360.0, 1.0f-2.0f*row/PI, 1.0f);
 
-            Object* sp = new Object(SpherePolygons, spheresId,
-                                    hue, glm::vec3(1.0, 1.0, 1.0), 120.0);
+            Material* m = materials->Add(new Material(hue, glm::vec3(1.0, 1.0, 1.0), 120.0));
+            Object* sp = new Object(SpherePolygons, m);
             float s = sin(row);
             float c = cos(row);
             ob->add(sp, Rotate(2,angle)*Translate(c,0,s)*Scale(0.075*c,0.075*c,0.075*c));
@@ -109,30 +132,85 @@ Object* SphereOfSpheres(Shape* SpherePolygons)
 
 ////////////////////////////////////////////////////////////////////////
 // Constructs a -1...+1  quad (canvas) framed by four (elongated) boxes
-Object* FramedPicture(const glm::mat4& modelTr, const int objectId, 
+Object* FramedPicture(const glm::mat4& modelTr, Material* boards, Material* picture,
                       Shape* BoxPolygons, Shape* QuadPolygons)
 {
     // This draws the frame as four (elongated) boxes of size +-1.0
     float w = 0.05;             // Width of frame boards.
     
-    Object* frame = new Object(NULL, nullId);
+    Object* frame = new Object(NULL);
     Object* ob;
     
-    glm::vec3 woodColor(87.0/255.0,51.0/255.0,35.0/255.0);
-    ob = new Object(BoxPolygons, frameId,
-                    woodColor, glm::vec3(0.2, 0.2, 0.2), 10.0);
+    ob = new Object(BoxPolygons, boards);
     frame->add(ob, Translate(0.0, 0.0, 1.0+w)*Scale(1.0, w, w));
     frame->add(ob, Translate(0.0, 0.0, -1.0-w)*Scale(1.0, w, w));
     frame->add(ob, Translate(1.0+w, 0.0, 0.0)*Scale(w, w, 1.0+2*w));
     frame->add(ob, Translate(-1.0-w, 0.0, 0.0)*Scale(w, w, 1.0+2*w));
 
-    ob = new Object(QuadPolygons, objectId,
-                    woodColor, glm::vec3(0.0, 0.0, 0.0), 10.0);
+    ob = new Object(QuadPolygons, picture);
     frame->add(ob, Rotate(0,90));
 
     return frame;
 }
 
+////////////////////////////////////////////////////////////////////////
+// Builds the companion program used by a pass to draw shapes made of
+// patches: the teapot tessellation stages, the pass's own vertex work
+// (in tail), and the pass's fragment shader, if it has one (frag may
+// be NULL), after fragPrelude (see ShaderProgram::AddShader).
+// Returns NULL if the program fails to link.
+ShaderProgram* PatchProgram(Resources* resources, const char* tail, const char* frag,
+                            const char* fragPrelude=NULL)
+{
+    std::string key = std::string("teapot.vert teapot.tesc teapot.tese ") + tail;
+    if (frag)
+        key = key + " " + frag;
+    ShaderProgram* program = resources->programs.Acquire(key);
+    if (program)
+        return program;
+
+    program = new ShaderProgram();
+    program->AddShader("teapot.vert", GL_VERTEX_SHADER);
+    program->AddShader("teapot.tesc", GL_TESS_CONTROL_SHADER);
+    program->AddShader("teapot.tese", GL_TESS_EVALUATION_SHADER);
+    program->AddShader(tail, GL_TESS_EVALUATION_SHADER);
+    if (frag)
+        program->AddShader(frag, GL_FRAGMENT_SHADER, fragPrelude);
+
+    glBindAttribLocation(program->programId, 0, "vertex");
+    program->LinkProgram();
+
+    int status;
+    glGetProgramiv(program->programId, GL_LINK_STATUS, &status);
+    if (status != 1) {
+        delete program;
+        return NULL; }
+
+    int loc = glGetUniformBlockIndex(program->programId, "TessBlock");
+    glUniformBlockBinding(program->programId, loc, tessBindpoint);
+    return resources->programs.Add(key, program);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Tells a program that shades with the shadow cascades where each one
+// reaches and how to find a point in it (see Cascade in gbuff.frag).
+void SetCascadeUniforms(const ShadowCascades& cascades, const int programId)
+{
+    int loc = glGetUniformLocation(programId, "cascades");
+    glUniform1i(loc, cascades.count);
+
+    float reach[MaxCascades], extent[MaxCascades];
+    for (int i=0;  i<cascades.count;  i++) {
+        reach[i] = cascades.split[i+1];
+        extent[i] = (float)cascades.resolution[i]/cascades.size; }
+    loc = glGetUniformLocation(programId, "cascadeFar");
+    glUniform1fv(loc, cascades.count, reach);
+    loc = glGetUniformLocation(programId, "cascadeExtent");
+    glUniform1fv(loc, cascades.count, extent);
+    loc = glGetUniformLocation(programId, "CascadeMatrix");
+    glUniformMatrix4fv(loc, cascades.count, GL_FALSE, &cascades.Matrix[0][0][0]);
+}
+
 ////////////////////////////////////////////////////////////////////////
 // InitializeScene is called once during setup to create all the
 // textures, shape VAOs, and shader programs as well as setting a
@@ -140,6 +218,7 @@ Object* FramedPicture(const glm::mat4& modelTr, const int objectId,
 void Scene::InitializeScene()
 {
     glEnable(GL_DEPTH_TEST);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);     // Filter across the sky's cube faces
     CHECKERROR;
 
     // @@ Initialize interactive viewing variables here. (spin, tilt, ry, front back, ...)
@@ -170,19 +249,38 @@ void Scene::InitializeScene()
     lightSpin = 150.0;
     lightTilt = -45.0;
     lightDist = 100.0;
+    shadowDraws = 0;
     // @@ Perhaps initialize additional scene lighting values here. (lightVal, lightAmb)
 
     
 
 
-    shadowFBO.CreateFBO(4000, 4000, false);
+    // The shadow maps hold depth alone, a layer a cascade (see
+    // cascades.h).  Its moments are taken as the filter first reads it,
+    // into compiledShadowFBO (or the summed-area table), quantized (see
+    // QuantizeMoments in filter-h.comp) or as floats.
+    GLenum shadowFormat = quantizeShadows ? GL_RGBA16 : GL_RGBA32F;
+    cascades.count = shadowCascades;
+    cascades.size = shadowSize;
+    for (int i=0;  i<shadowCascades;  i++)
+        cascades.resolution[i] = cascadeSize[i];
+    shadowFBO.CreateArrayFBO(shadowSize, shadowSize, shadowCascades, GL_DEPTH_COMPONENT32F);
     lowerReflectFBO.CreateFBO(1000, 1000, false);
     upperReflectFBO.CreateFBO(1000, 1000, false);
     GBufferFBO.CreateFBO(1000, 1000, true);
-    compiledShadowFBO.CreateFBO(4000, 4000, false);
+    compiledShadowFBO.CreateArrayFBO(shadowSize, shadowSize, shadowCascades, shadowFormat);
+    if (cacheShadows) {
+        shadowCache.Create(shadowSize, shadowSize, shadowCascades);
+        printf("Static shadow cache: %.0f MB\n", shadowCache.statics.Bytes()/(1024.0*1024.0)); }
+    printf("Shadow maps: %d cascades of %d x %d, %.0f MB\n", shadowCascades, shadowSize, shadowSize,
+           (shadowFBO.Bytes() + compiledShadowFBO.Bytes())/(1024.0*1024.0));
 
     CHECKERROR;
-    objectRoot = new Object(NULL, nullId);
+    objectRoot = new Object(NULL);
+
+    // Textures, shader programs and shapes are shared through this,
+    // which keeps one of each per file and parameters (resources.h).
+    resources = new Resources();
 
     
     // Enable OpenGL depth-testing
@@ -192,7 +290,7 @@ void Scene::InitializeScene()
     // @@ Initialize additional shaders if necessary
     lightingProgram = new ShaderProgram();
     lightingProgram->AddShader("multilight.vert", GL_VERTEX_SHADER);
-    lightingProgram->AddShader("multilight.frag", GL_FRAGMENT_SHADER);
+    lightingProgram->AddShader("multilight.frag", GL_FRAGMENT_SHADER, MomentsGLSL);
 
     // lightingProgram->AddShader("final.vert", GL_VERTEX_SHADER);
     // lightingProgram->AddShader("final.frag", GL_FRAGMENT_SHADER);
@@ -204,14 +302,19 @@ void Scene::InitializeScene()
     glBindAttribLocation(lightingProgram->programId, 2, "vertexTexture");
     glBindAttribLocation(lightingProgram->programId, 3, "vertexTangent");
     lightingProgram->LinkProgram();
+    resources->programs.Add("multilight.vert multilight.frag", lightingProgram);
 
 
 
+    // Depth only:  no fragment shader, and positions alone from the
+    // shapes.
     shadowProgram = new ShaderProgram();
     shadowProgram->AddShader("shadow.vert", GL_VERTEX_SHADER);
-    shadowProgram->AddShader("shadow.frag", GL_FRAGMENT_SHADER);
+    shadowProgram->positionsOnly = true;
 
+    glBindAttribLocation(shadowProgram->programId, 0, "vertex");
     shadowProgram->LinkProgram();
+    resources->programs.Add("shadow.vert", shadowProgram);
 
 
 
@@ -222,6 +325,7 @@ void Scene::InitializeScene()
     reflectionProgram->AddShader("lighting.frag", GL_FRAGMENT_SHADER);
 
     reflectionProgram->LinkProgram();
+    resources->programs.Add("reflect.vert reflect.frag lighting.vert lighting.frag", reflectionProgram);
 
 
 
@@ -234,6 +338,17 @@ void Scene::InitializeScene()
     glBindAttribLocation(GBufferProgram->programId, 2, "vertexTexture");
     glBindAttribLocation(GBufferProgram->programId, 3, "vertexTangent");
     GBufferProgram->LinkProgram();
+    resources->programs.Add("gbuff.vert gbuff.frag", GBufferProgram);
+
+
+
+    // The sky is drawn last, over whatever no geometry covered.
+    skyProgram = new ShaderProgram();
+    skyProgram->AddShader("sky.vert", GL_VERTEX_SHADER);
+    skyProgram->AddShader("sky.frag", GL_FRAGMENT_SHADER);
+    skyProgram->LinkProgram();
+    resources->programs.Add("sky.vert sky.frag", skyProgram);
+    glGenVertexArrays(1, &skyVAO);
 
 
 
@@ -247,6 +362,7 @@ void Scene::InitializeScene()
     glBindAttribLocation(localLightProgram->programId, 3, "vertexTangent");
 
     localLightProgram->LinkProgram();
+    resources->programs.Add("localLight.vert localLight.frag", localLightProgram);
 
 
     /*
@@ -259,34 +375,59 @@ void Scene::InitializeScene()
 
 
 
-    choleskyProgram = new ShaderProgram();
-    choleskyProgram->AddShader("cholesky.comp", GL_COMPUTE_SHADER);
-
-    choleskyProgram->LinkProgram();
+    // Filters the moments of shadowFBO's depth:  a summed-area table
+    // of them, or a blur into compiledShadowFBO.
+    FilterSource momentSource = quantizeShadows ? SOURCE_QUANTIZED_MOMENTS : SOURCE_MOMENTS;
+    if (summedAreaShadows) {
+        shadowSAT.Create(resources, shadowSize, shadowSize, shadowCascades);
+        shadowSAT.source = momentSource;
+        printf("Shadow summed-area table: %.0f MB\n", shadowSAT.Bytes()/(1024.0*1024.0)); }
+    else {
+        shadowFilter.Create(resources, shadowSize, shadowSize, shadowCascades, shadowFormat);
+        shadowFilter.SetGaussian(shadowBlur);
+        shadowFilter.source = momentSource;
+        printf("Shadow blur: %.0f MB\n", shadowFilter.Bytes()/(1024.0*1024.0)); }
+    imageOps.Create(resources, &gpuTimers);
     CHECKERROR;
 
 
-
-    choleskyProgramV = new ShaderProgram();
-    choleskyProgramV->AddShader("cholesky-v.comp", GL_COMPUTE_SHADER);
-
-    choleskyProgramV->LinkProgram();
+    
+    // The tessellated teapot needs OpenGL 4.0, and a patch program for
+    // each pass that draws it.  Otherwise fall back to the CPU teapot.
+    int glMajor;
+    glGetIntegerv(GL_MAJOR_VERSION, &glMajor);
+    bool tessellate = tessellateTeapot && fullPolyCount && glMajor >= 4;
+    if (tessellate) {
+        shadowProgram->patchProgram = PatchProgram(resources, "shadowPatch.tese", NULL);
+        GBufferProgram->patchProgram = PatchProgram(resources, "gbuffPatch.tese", "gbuff.frag");
+        lightingProgram->patchProgram = PatchProgram(resources, "multilightPatch.tese", "multilight.frag", MomentsGLSL);
+        tessellate = shadowProgram->patchProgram && GBufferProgram->patchProgram
+            && lightingProgram->patchProgram; }
+    if (tessellate) {
+        glGenBuffers(1, &tessBlockID); }
+    else {
+        printf("Tessellation unavailable; using the CPU teapot\n");
+        shadowProgram->patchProgram = GBufferProgram->patchProgram = lightingProgram->patchProgram = NULL; }
     CHECKERROR;
 
-
-    
-    // Create all the Polygon shapes
-    Shape* TeapotPolygons =  new Teapot(fullPolyCount?12:2);
-    Shape* BoxPolygons = new Box();
-    Shape* SpherePolygons = new Sphere(32);
-    Shape* RoomPolygons = new Ply("room.ply");
-    Shape* FloorPolygons = new Plane(10.0, 10);
-    Shape* QuadPolygons = new Quad();
-    Shape* SeaPolygons = new Plane(2000.0, 50);
+    // Create all the Polygon shapes, each keyed by its parameters
+    ResourceCache<Shape>& shapes = resources->shapes;
+    Shape* TeapotPolygons;
+    if (tessellate)
+        TeapotPolygons = shapes.Get("TeapotPatches", []() { return new TeapotPatches(); });
+    else
+        TeapotPolygons = shapes.Get(fullPolyCount ? "Teapot 12" : "Teapot 2",
+                                    []() { return new Teapot(fullPolyCount?12:2); });
+    Shape* BoxPolygons = shapes.Get("Box", []() { return new Box(); });
+    Shape* SpherePolygons = shapes.Get("Sphere 32", []() { return new Sphere(32); });
+    Shape* RoomPolygons = shapes.Get("Ply room.ply", []() { return new Ply("room.ply"); });
+    Shape* FloorPolygons = shapes.Get("Plane 10 10", []() { return new Plane(10.0, 10); });
+    Shape* QuadPolygons = shapes.Get("Quad 1", []() { return new Quad(); });
+    Shape* SeaPolygons = shapes.Get("Plane 2000 50", []() { return new Plane(2000.0, 50); });
     ground = new ProceduralGround(grndSize, 400,
                                      grndOctaves, grndFreq, grndPersistence,
                                      grndLow, grndHigh);
-    Shape* GroundPolygons = ground;
+    Shape* GroundPolygons = shapes.Add("ProceduralGround", ground);
 
     // Various colors used in the subsequent models
     glm::vec3 woodColor(87.0/255.0, 51.0/255.0, 35.0/255.0);
@@ -300,31 +441,92 @@ void Scene::InitializeScene()
     glm::vec3 brightSpec(0.03, 0.03, 0.03);
     glm::vec3 polishedSpec(0.01, 0.01, 0.01);
  
-    // Creates all the models from which the scene is composed.  Each
-    // is created with a polygon shape (possibly NULL), a
-    // transformation, and the surface lighting parameters Kd, Ks, and
-    // alpha.
-
-    // @@ This is where you could read in all the textures and
-    // associate them with the various objects being created in the
-    // next dozen lines of code.
+    // Load in sky texture.  Images are decoded in the background and
+    // uploaded by DrawScene as they arrive;  until then each texture
+    // shows a flat placeholder.  The skies are equirectangular images,
+    // resampled into cube maps (see envcube.h).  The sky and its
+    // irradiance map are the same file here, so they share one
+    // texture, held twice.
+    textureLoader = new TextureLoader(&resources->textures);
+    skyTex = textureLoader->LoadCube("./textures/IBL/Sierra_Madre_B_Ref.irr.hdr");
+    skyIrr = textureLoader->LoadCube("./textures/IBL/Sierra_Madre_B_Ref.irr.hdr");
+    skyTex2 = textureLoader->LoadCube("./textures/IBL/Alexs_Apt_2k.irr.hdr");
+    skyIrr2 = textureLoader->LoadCube("./textures/IBL/Alexs_Apt_2k.irr.hdr");
+
+    // Every object's surface is a Material, kept in the material
+    // table, which the shaders index with the material's number.
+    // Until all the textures arrive, objects show their diffuse colors.
+    materials = new MaterialTable(textureLoader, &resources->textures);
+
+    // @@ To change an object's surface parameters (Kd, Ks, alpha,
+    // textures), modify the following lines.
+
+    Material* wallMat = new Material(brickColor, black, 1);
+    wallMat->albedo = "./textures/Standard_red_pxr128.png";
+    wallMat->normal = "./textures/Standard_red_pxr128_normal.png";
+    wallMat->uvTransform = glm::mat2(0.0f, -20.0f, 20.0f, 0.0f);
+    wallMat->tint = glm::vec3(0.9f);
+    materials->Add(wallMat);
+
+    Material* floorMat = new Material(floorColor, black, 1);
+    floorMat->albedo = "./textures/6670-diffuse.jpg";
+    floorMat->normal = "./textures/6670-normal.jpg";
+    floorMat->uvTransform = glm::mat2(4.0f);
+    materials->Add(floorMat);
+
+    Material* teapotMat = new Material(brassColor, brightSpec, 120, MAT_REFLECTIVE);
+    teapotMat->albedo = "./textures/cracks.png";
+    teapotMat->uvTransform = glm::mat2(8.0f);
+    materials->Add(teapotMat);
+
+    Material* podiumMat = new Material(woodColor, polishedSpec, 10);
+    podiumMat->albedo = "./textures/Brazilian_rosewood_pxr128.png";
+    podiumMat->normal = "./textures/Brazilian_rosewood_pxr128_normal.png";
+    materials->Add(podiumMat);
+
+    Material* boardMat = new Material(woodColor, glm::vec3(0.2, 0.2, 0.2), 10);
+    boardMat->albedo = "./textures/Brazilian_rosewood_pxr128.png";
+    boardMat->normal = "./textures/Brazilian_rosewood_pxr128_normal.png";
+    materials->Add(boardMat);
+
+    Material* leftPicMat = new Material(woodColor, black, 10);
+    leftPicMat->albedo = "./textures/angry.png";
+    materials->Add(leftPicMat);
+
+    Material* rightPicMat = new Material(woodColor, black, 10);
+    rightPicMat->albedo = "./textures/cow.png";
+    materials->Add(rightPicMat);
+
+    Material* groundMat = new Material(grassColor, black, 1);
+    groundMat->albedo = "./textures/grass.jpg";
+    groundMat->uvTransform = glm::mat2(100.0f);
+    materials->Add(groundMat);
+
+    Material* seaMat = new Material(waterColor, brightSpec, 120, MAT_SKY_REFLECT);
+    seaMat->normal = "./textures/ripples_normalmap.png";
+    seaMat->uvTransform = glm::mat2(10.0f);
+    seaMat->uvScroll = glm::vec2(-0.001, 0.001);
+    materials->Add(seaMat);
+
+    Material* pbsMat = materials->Add(new Material(glm::vec3(.5, .5, .5), brightSpec, 10, MAT_REFLECTIVE));
 
-    // @@ To change an object's surface parameters (Kd, Ks, or alpha),
-    // modify the following lines.
-    
-    Object* central    = new Object(NULL, nullId);
-    Object* anim       = new Object(NULL, nullId);
-    Object* room       = new Object(RoomPolygons, roomId, brickColor, black, 1);
-    Object* floor      = new Object(FloorPolygons, floorId, floorColor, black, 1);
-    Object* teapot     = new Object(TeapotPolygons, teapotId, brassColor, brightSpec, 120, true);
-    Object* podium     = new Object(BoxPolygons, boxId, glm::vec3(woodColor), polishedSpec, 10); 
-    Object* sky        = new Object(SpherePolygons, skyId, black, black, 0, true);
-    Object* ground     = new Object(GroundPolygons, groundId, grassColor, black, 1);
-    Object* sea        = new Object(SeaPolygons, seaId, waterColor, brightSpec, 120);
-    Object* spheres    = SphereOfSpheres(SpherePolygons);
-    Object* leftFrame  = FramedPicture(Identity, lPicId, BoxPolygons, QuadPolygons);
-    Object* rightFrame = FramedPicture(Identity, rPicId, BoxPolygons, QuadPolygons);
-    Object* proj3Sphere = new Object(SpherePolygons, pbsSphere, glm::vec3(.5, .5, .5), brightSpec, 10, true);
+    // Creates all the models from which the scene is composed.  Each
+    // is created with a polygon shape (possibly NULL) and a material,
+    // and placed with a transformation.
+
+    Object* central    = new Object(NULL);
+    Object* anim       = new Object(NULL);
+    Object* room       = new Object(RoomPolygons, wallMat);
+    Object* floor      = new Object(FloorPolygons, floorMat);
+    Object* teapot     = new Object(TeapotPolygons, teapotMat);
+    Object* podium     = new Object(BoxPolygons, podiumMat); 
+    Object* ground     = new Object(GroundPolygons, groundMat);
+    Object* sea        = new Object(SeaPolygons, seaMat);
+    sea->castsShadow = false;   // Flat, and under everything
+    Object* spheres    = SphereOfSpheres(SpherePolygons, materials);
+    Object* leftFrame  = FramedPicture(Identity, boardMat, leftPicMat, BoxPolygons, QuadPolygons);
+    Object* rightFrame = FramedPicture(Identity, boardMat, rightPicMat, BoxPolygons, QuadPolygons);
+    Object* proj3Sphere = new Object(SpherePolygons, pbsMat);
 
 
     // @@ To change the scene hierarchy, examine the hierarchy created
@@ -332,9 +534,9 @@ void Scene::InitializeScene()
     // The objects being manipulated and their polygon shapes are
     // created above here.
 
-    // Scene is composed of sky, ground, sea, room and some central models
+    // Scene is composed of ground, sea, room and some central models,
+    // under a sky (drawn by its own pass in DrawScene)
     if (fullPolyCount) {
-        objectRoot->add(sky, Scale(2000.0, 2000.0, 2000.0));
         objectRoot->add(sea); 
         objectRoot->add(ground); 
     }
@@ -346,6 +548,7 @@ void Scene::InitializeScene()
 
     // Central model has a rudimentary animation (constant rotation on Z)
     animated.push_back(anim);
+    anim->staticCaster = false;
 
     // Central contains a teapot on a podium and an external sphere of spheres
     central->add(podium, Translate(0.0, 0,0));
@@ -363,28 +566,11 @@ void Scene::InitializeScene()
 
     CHECKERROR;
 
-    // Load in sky texture
-    skyTex = new Texture("./textures/IBL/Sierra_Madre_B_Ref.irr.hdr");
-    skyIrr = new Texture("./textures/IBL/Sierra_Madre_B_Ref.irr.hdr");
-    skyTex2 = new Texture("./textures/IBL/Alexs_Apt_2k.irr.hdr");
-    skyIrr2 = new Texture("./textures/IBL/Alexs_Apt_2k.irr.hdr");
-    seaNormal = new Texture("./textures/ripples_normalmap.png");
-    groundTex = new Texture("./textures/grass.jpg");
-    wallTex = new Texture("./textures/Standard_red_pxr128.png");
-    wallNormal = new Texture("./textures/Standard_red_pxr128_normal.png");
-    floorTex = new Texture("./textures/6670-diffuse.jpg");
-    floorNormal = new Texture("./textures/6670-normal.jpg");
-    teapotTex = new Texture("./textures/cracks.png");
-    frameTex = new Texture("./textures/Brazilian_rosewood_pxr128.png");
-    frameNormal = new Texture("./textures/Brazilian_rosewood_pxr128_normal.png");
-    lFrameTex = new Texture("./textures/angry.png");
-    rFrameTex = new Texture("./textures/cow.png");
-
     CHECKERROR;
 
     total_time = 0.0;
     
-    block.N = N; // N=20 ... 40 or whatever 
+    block.N = N; // N=20 ... 40 or whatever 
     int kk;
     float p, u;
     int pos = 0;
@@ -431,6 +617,10 @@ void Scene::BuildTransforms()
 // goals.)
 void Scene::DrawScene()
 {
+    // Upload any textures decoded since the last frame
+    textureLoader->Update();
+    materials->Update();
+
     // Set the viewport
     glfwGetFramebufferSize(window, &width, &height);
     glViewport(0, 0, width, height);
@@ -446,6 +636,11 @@ void Scene::DrawScene()
     for (std::vector<Object*>::iterator m=animated.begin();  m<animated.end();  m++)
         (*m)->animTr = Rotate(2, atime);
 
+    // Every pass draws the hierarchy as this one sorted list, but the
+    // shadow pass, which draws only the casters.
+    drawList.Build(objectRoot, Identity);
+    casterList.Build(objectRoot, Identity, true);
+
     now_time = glfwGetTime();
     time_since_last_refresh = now_time - prev_time;
     prev_time = now_time;
@@ -487,8 +682,16 @@ void Scene::DrawScene()
     int loc, programId;
     glm::vec3 Light(3, 3, 3), Ambient(0.2, 0.2, 0.2);
 
-    glm::mat4 Vl = LookAt(lightPos, glm::vec3(0, 0, 0), glm::vec3(0, 0, 1));
-    glm::mat4 Pl = Perspective(40/lightDist, 40/lightDist, front, back);
+    cascades.Fit(WorldView, WorldProj, lightPos);
+
+    // Tessellated patches are measured in the camera's view in every pass.
+    if (GBufferProgram->patchProgram) {
+        tessBlock.viewProj = WorldProj*WorldView;
+        tessBlock.params = glm::vec4(width, height, tessPixels, tessMaxLevel);
+        glBindBuffer(GL_UNIFORM_BUFFER, tessBlockID);
+        glBindBufferBase(GL_UNIFORM_BUFFER, tessBindpoint, tessBlockID);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(tessBlock), &tessBlock, GL_DYNAMIC_DRAW);
+        CHECKERROR; }
     
 
     
@@ -497,35 +700,72 @@ void Scene::DrawScene()
     // glBindTexture(GL_TEXTURE_2D, shadowMap);
 
     {
+        gpuTimers.Begin("Shadow pass");
         shadowProgram->Use();
-        shadowFBO.Bind();
-
-        glViewport(0, 0, 4000, 4000);
-        glClearColor(0.5, 0.5, 0.5, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        // Casters in front of a cascade's near plane are clamped onto
+        // it rather than clipped.
         glEnable(GL_CULL_FACE);
         glCullFace(GL_FRONT);
+        glEnable(GL_DEPTH_CLAMP);
 
         programId = shadowProgram->programId;
 
-        loc = glGetUniformLocation(programId, "Proj");     // perspective
-        glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(Pl));
+        // Each cascade's depth is drawn into its own layer, cleared to
+        // the far plane.
+        glClearDepth(1.0);
+
+        // With cacheShadows, a layer starts as a copy of its static
+        // casters (redrawn only when stale), and the moving casters are
+        // drawn on top.  A layer where nothing changed is left from
+        // last frame.  Each layer draws only the casters that reach
+        // its cascade.
+        if (cacheShadows)
+            shadowCache.Update(cascades, casterList, summedAreaShadows ? 0 : shadowFilter.radius);
+        int draws = 0;
+        for (int i=0;  i<cascades.count;  i++) {
+            if (cacheShadows && shadowCache.Clean(i))
+                continue;
+            int n = cascades.resolution[i];
+            glViewport(0, 0, n, n);
+
+            loc = glGetUniformLocation(programId, "Proj");     // orthographic
+            glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(cascades.Proj[i]));
+
+            loc = glGetUniformLocation(programId, "View");
+            glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(cascades.View[i]));
+            CHECKERROR;
 
-        loc = glGetUniformLocation(programId, "View");
-        glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(Vl));
+            glm::mat4 volume = cascades.Proj[i]*cascades.View[i];
+            if (!cacheShadows) {
+                shadowFBO.BindLayer(i);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                draws += casterList.Draw(shadowProgram, DRAW_ALL, &volume);
+                CHECKERROR;
+                continue; }
 
-        loc = glGetUniformLocation(programId, "mode");
-        glUniform1i(loc, mode);
+            if (shadowCache.staticDirty[i]) {
+                shadowCache.statics.BindLayer(i);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                draws += casterList.Draw(shadowProgram, DRAW_STATIC, &volume); }
 
-        CHECKERROR;
+            // Depth needs restoring only where the moving casters were.
+            const int* r = shadowCache.region[i];
+            glCopyImageSubData(shadowCache.statics.textureID[0], GL_TEXTURE_2D_ARRAY, 0, r[0], r[1], i,
+                               shadowFBO.textureID[0], GL_TEXTURE_2D_ARRAY, 0, r[0], r[1], i,
+                               r[2] - r[0], r[3] - r[1], 1);
 
-        objectRoot->Draw(shadowProgram, Identity);
-        CHECKERROR;
+            shadowFBO.BindLayer(i);
+            draws += casterList.Draw(shadowProgram, DRAW_DYNAMIC, &volume);
+            CHECKERROR; }
+
+        shadowDraws = draws;
 
+        glDisable(GL_DEPTH_CLAMP);
         glDisable(GL_CULL_FACE);
         shadowFBO.Unbind();
         shadowProgram->Unuse();
+        gpuTimers.End();
         CHECKERROR;
     }
 
@@ -533,9 +773,6 @@ void Scene::DrawScene()
     glm::mat4 ShadowMatrix = MatrixMult(Scale(.5, .5, .5), Translate(.5, .5, .5));
     ShadowMatrix = MatrixMult(ShadowMatrix, MatrixMult(Vl, Pl));
     */
-    glm::mat4 ShadowMatrix;
-    ShadowMatrix = Translate(.5, .5, .5) * Scale(.5, .5, .5);
-    ShadowMatrix = ShadowMatrix * Pl * Vl;
 
 
 
@@ -545,110 +782,17 @@ void Scene::DrawScene()
     ////////////////////////////////////////////////////////////////////////////////
 
     
-    {
-        int blurW = 10;
-        /*
-        if (mode == 2) {
-            blurW = 0;
-        }
-        if (mode == 3) {
-            blurW = 50;
-        }
-        */
-
-        float s = (float)blurW / 2;
-        float weights[101];
-        float sum = 0;
-        for (int i = 0; i < blurW * 2 + 1; i++)
-        {
-            weights[i] = expf(-.5 * powf((i - blurW) / s, 2));
-            sum += weights[i];
-        }
-        for (int i = 0; i < blurW * 2 + 1; i++)
-        {
-            weights[i] /= sum;
-        }
-
-
-        choleskyProgram->Use();
-        programId = choleskyProgram->programId;
-
-
-        GLuint blockID;
-        glGenBuffers(1, &blockID); // Generates block
-        int bindpoint = 0; // Start at zero, increment for other blocks
-
-        loc = glGetUniformBlockIndex(programId, "blurKernel");
-        glUniformBlockBinding(programId, loc, bindpoint);
-
-        glBindBuffer(GL_UNIFORM_BUFFER, blockID);
-        glBindBufferBase(GL_UNIFORM_BUFFER, bindpoint, blockID);
-        glBufferData(GL_UNIFORM_BUFFER, (blurW * 2 + 1) * sizeof(float), &weights, GL_STATIC_DRAW);
-
-
-        loc = glGetUniformLocation(programId, "w");
-        glUniform1i(loc, blurW);
-
-
-        loc = glGetUniformLocation(programId, "src"); // Perhaps "src" and "dst"
-        CHECKERROR;
-        glBindImageTexture(0, shadowFBO.textureID[0], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-        CHECKERROR;
-        glUniform1i(loc, 0);
-
-        loc = glGetUniformLocation(programId, "dst"); // Perhaps "src" and "dst"
-        glBindImageTexture(1, compiledShadowFBO.textureID[0], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-        glUniform1i(loc, 1);
-
-
-
-        glDispatchCompute((4000 / 128) + 1, 4000, 1); // Tiles WxH image with groups sized 128x1
-        //glDispatchCompute(fboWidth, fboHeight/128, 1); // Tiles WxH image with groups sized 128x1
-
-        choleskyProgram->Unuse();
-
-
-        /// <summary>
-        /// 
-        /// </summary>
-        choleskyProgramV->Use();
-        programId = choleskyProgramV->programId;
-
-
-        glGenBuffers(1, &blockID); // Generates block
-        bindpoint = 1; // Start at zero, increment for other blocks
-
-        loc = glGetUniformBlockIndex(programId, "blurKernel");
-        glUniformBlockBinding(programId, loc, bindpoint);
-
-        glBindBuffer(GL_UNIFORM_BUFFER, blockID);
-        glBindBufferBase(GL_UNIFORM_BUFFER, bindpoint, blockID);
-        glBufferData(GL_UNIFORM_BUFFER, (blurW * 2 + 1) * sizeof(float), &weights, GL_STATIC_DRAW);
-
-
-        loc = glGetUniformLocation(programId, "w");
-        glUniform1i(loc, blurW);
-
-
-        loc = glGetUniformLocation(programId, "src"); // Perhaps "src" and "dst"
-        CHECKERROR;
-        glBindImageTexture(0, shadowFBO.textureID[0], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-        CHECKERROR;
-        glUniform1i(loc, 0);
-
-        loc = glGetUniformLocation(programId, "dst"); // Perhaps "src" and "dst"
-        glBindImageTexture(1, compiledShadowFBO.textureID[0], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-        glUniform1i(loc, 1);
-        // Change GL_READ_ONLY to GL_WRITE_ONLY for output image
-        // Note: GL_RGBA32F means 4 channels (RGBA) of 32 bit floats.
-
-
-
-        glDispatchCompute((4000 / 128) + 1, 4000, 1); // Tiles WxH image with groups sized 128x1
-        //glDispatchCompute(fboWidth, fboHeight/128, 1); // Tiles WxH image with groups sized 128x1
-
-        choleskyProgramV->Unuse();
-    }
+    // A layer a cascade, each over the part of it in use (and with
+    // cacheShadows, only where it changed)
+    const int* changed = cacheShadows ? shadowCache.region[0] : NULL;
+    gpuTimers.Begin("Shadow filter");
+    if (summedAreaShadows)
+        shadowSAT.Build(shadowFBO.textureID[0], cascades.resolution, cascades.count, changed);
+    else
+        shadowFilter.Apply(shadowFBO.textureID[0], compiledShadowFBO.textureID[0],
+                           cascades.resolution, cascades.count, changed);
+    gpuTimers.End();
+    CHECKERROR;
     
 
     /*
@@ -762,11 +906,10 @@ void Scene::DrawScene()
         loc = glGetUniformLocation(programId, "Ambient");
         glUniform3fv(loc, 1, &(Ambient[0]));
 
-        loc = glGetUniformLocation(programId, "ShadowMatrix");
-        glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(ShadowMatrix));
+        SetCascadeUniforms(cascades, programId);
 
         glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, shadowFBO.textureID[0]);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, shadowFBO.textureID[0]);
         loc = glGetUniformLocation(programId, "shadowMap");
         glUniform1i(loc, 2);
 
@@ -785,103 +928,20 @@ void Scene::DrawScene()
         {
             int unit = 5;
             glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, skyTex->textureId);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, skyTex->textureId);
             loc = glGetUniformLocation(programId, "skyTex");
             glUniform1i(loc, unit);
 
+            // Material texture arrays and the material table
             unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, skyTex2->textureId);
-            loc = glGetUniformLocation(programId, "skyTex2");
-            glUniform1i(loc, unit);
-
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, groundTex->textureId);
-            loc = glGetUniformLocation(programId, "groundTex");
-            glUniform1i(loc, unit);
-
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, wallTex->textureId);
-            loc = glGetUniformLocation(programId, "wallTex");
-            glUniform1i(loc, unit);
-
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, floorTex->textureId);
-            loc = glGetUniformLocation(programId, "floorTex");
-            glUniform1i(loc, unit);
-
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, teapotTex->textureId);
-            loc = glGetUniformLocation(programId, "teapotTex");
-            glUniform1i(loc, unit);
-
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, frameTex->textureId);
-            loc = glGetUniformLocation(programId, "frameTex");
-            glUniform1i(loc, unit);
-
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, lFrameTex->textureId);
-            loc = glGetUniformLocation(programId, "lFrameTex");
-            glUniform1i(loc, unit);
-
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, rFrameTex->textureId);
-            loc = glGetUniformLocation(programId, "rFrameTex");
-            glUniform1i(loc, unit);
-
-            //// Normal Maps
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, wallNormal->textureId);
-            loc = glGetUniformLocation(programId, "wallNormal");
-            glUniform1i(loc, unit);
-
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, floorNormal->textureId);
-            loc = glGetUniformLocation(programId, "floorNormal");
-            glUniform1i(loc, unit);
-
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, frameNormal->textureId);
-            loc = glGetUniformLocation(programId, "frameNormal");
-            glUniform1i(loc, unit);
-
-            unit++;
-
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, seaNormal->textureId);
-            loc = glGetUniformLocation(programId, "seaNormal");
-            glUniform1i(loc, unit);
-
-            
+            materials->Bind(programId, unit);
         }
 
         GLenum attachments[4] = { GL_COLOR_ATTACHMENT0_EXT, GL_COLOR_ATTACHMENT1_EXT, GL_COLOR_ATTACHMENT2_EXT, GL_COLOR_ATTACHMENT3_EXT };
         glDrawBuffers(4, attachments);
         CHECKERROR;
 
-        objectRoot->Draw(GBufferProgram, Identity);
+        drawList.Draw(GBufferProgram);
         CHECKERROR;
 
         GBufferFBO.Unbind();
@@ -951,13 +1011,7 @@ void Scene::DrawScene()
     loc = glGetUniformLocation(programId, "Ambient");
     glUniform3fv(loc, 1, &(Ambient[0]));
 
-    loc = glGetUniformLocation(programId, "ShadowMatrix");
-    glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(ShadowMatrix));
-
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, shadowFBO.textureID[0]);
-    loc = glGetUniformLocation(programId, "shadowMap");
-    glUniform1i(loc, 2);
+    SetCascadeUniforms(cascades, programId);
 
     
     glActiveTexture(GL_TEXTURE3);
@@ -1002,21 +1056,45 @@ void Scene::DrawScene()
         unit++;
 
         glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(GL_TEXTURE_2D, compiledShadowFBO.textureID[0]);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, compiledShadowFBO.textureID[0]);
         loc = glGetUniformLocation(programId, "choleskyMap");
         glUniform1i(loc, unit);
 
+        loc = glGetUniformLocation(programId, "quantized");
+        glUniform1i(loc, quantizeShadows);
+
+        unit++;
+
+        // Bound either way, as no two sampler types may share a unit.
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, shadowSAT.texture);
+        loc = glGetUniformLocation(programId, "satMap");
+        glUniform1i(loc, unit);
+
+        loc = glGetUniformLocation(programId, "summedArea");
+        glUniform1i(loc, summedAreaShadows);
+
+        // Penumbra texels per unit of depth between blocker and receiver
+        float penumbra[MaxCascades];
+        for (int i=0;  i<cascades.count;  i++)
+            penumbra[i] = lightAngle*cascades.depthRange[i]/cascades.texel[i];
+        loc = glGetUniformLocation(programId, "cascadePenumbra");
+        glUniform1fv(loc, cascades.count, penumbra);
+
+        loc = glGetUniformLocation(programId, "searchRadius");
+        glUniform1i(loc, shadowSearch);
+
         unit++;
 
         glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(GL_TEXTURE_2D, skyIrr->textureId);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyIrr->textureId);
         loc = glGetUniformLocation(programId, "skyIrr");
         glUniform1i(loc, unit);
 
         unit++;
 
         glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(GL_TEXTURE_2D, skyIrr2->textureId);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyIrr2->textureId);
         loc = glGetUniformLocation(programId, "skyIrr2");
         glUniform1i(loc, unit);
 
@@ -1040,7 +1118,7 @@ void Scene::DrawScene()
     CHECKERROR;
 
     // Draw all objects (This recursively traverses the object hierarchy.)
-    objectRoot->Draw(lightingProgram, Identity);
+    drawList.Draw(lightingProgram);
     CHECKERROR; 
 
     /*
@@ -1058,6 +1136,49 @@ void Scene::DrawScene()
     // End of Lighting pass
     ////////////////////////////////////////////////////////////////////////////////
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // Sky pass:  one triangle at the far plane.  The lighting pass
+    // drew only the geometry, so its depth buffer still holds the
+    // cleared 1.0 exactly where the sky shows, and GL_LEQUAL lets the
+    // sky through there alone.  (The G-buffer debugging modes show
+    // nothing there, as before.)
+    ////////////////////////////////////////////////////////////////////////////////
+    if (fullPolyCount && (mode <= 2 || mode >= 7)) {
+        skyProgram->Use();
+        programId = skyProgram->programId;
+
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+
+        loc = glGetUniformLocation(programId, "WorldProj");
+        glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(WorldProj));
+
+        loc = glGetUniformLocation(programId, "WorldInverse");
+        glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(WorldInverse));
+
+        loc = glGetUniformLocation(programId, "mode");
+        glUniform1i(loc, mode);
+
+        glActiveTexture(GL_TEXTURE5);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyTex->textureId);
+        loc = glGetUniformLocation(programId, "skyTex");
+        glUniform1i(loc, 5);
+
+        glActiveTexture(GL_TEXTURE6);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyTex2->textureId);
+        loc = glGetUniformLocation(programId, "skyTex2");
+        glUniform1i(loc, 6);
+
+        glBindVertexArray(skyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+        skyProgram->Unuse();
+        CHECKERROR;
+    }
+
     if (mode <= 2) {
         /////// Local lights
         localLightProgram->Use();
@@ -1105,13 +1226,6 @@ void Scene::DrawScene()
         loc = glGetUniformLocation(programId, "Ambient");
         glUniform3fv(loc, 1, &(Ambient[0]));
 
-        loc = glGetUniformLocation(programId, "ShadowMatrix");
-        glUniformMatrix4fv(loc, 1, GL_FALSE, Pntr(ShadowMatrix));
-
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, shadowFBO.textureID[0]);
-        loc = glGetUniformLocation(programId, "shadowMap");
-        glUniform1i(loc, 2);
 
 
         glActiveTexture(GL_TEXTURE3);
@@ -15,23 +15,15 @@
 #include "shapes.h"
 #include "object.h"
 #include "texture.h"
+#include "materialtable.h"
 #include "fbo.h"
-
-enum ObjectIds {
-    nullId	= 0,
-    skyId	= 1,
-    seaId	= 2,
-    groundId	= 3,
-    roomId	= 4,
-    boxId	= 5,
-    frameId	= 6,
-    lPicId	= 7,
-    rPicId	= 8,
-    teapotId	= 9,
-    spheresId	= 10,
-    floorId     = 11,
-    pbsSphere = 12
-};
+#include "cascades.h"
+#include "separablefilter.h"
+#include "summedarea.h"
+#include "shadowcache.h"
+#include "gputimers.h"
+#include "imageops.h"
+#include "resources.h"
 
 class Shader;
 
@@ -52,6 +44,12 @@ public:
     double total_time;
 
     FBO shadowFBO, upperReflectFBO, lowerReflectFBO, GBufferFBO, compiledShadowFBO;
+    ShadowCascades cascades;    // Fit to the view each frame
+    SeparableFilter shadowFilter;
+    SummedAreaTable shadowSAT;
+    ShadowCache shadowCache;
+    GpuTimers gpuTimers;        // Shadow pass, filter and imageOps timings (the T key)
+    ImageOps imageOps;          // Compute image processing on render targets
     GLuint shadowMap;
 
     // Light parameters
@@ -72,6 +70,9 @@ public:
 
     // All objects in the scene are children of this single root object.
     Object* objectRoot;
+    DrawList drawList;          // objectRoot flattened, rebuilt each frame
+    DrawList casterList;        // Its shadow casters alone
+    int shadowDraws;            // Draws by the last frame's shadow pass, every cascade's
     std::vector<Object*> animated;
 
     // Shader programs
@@ -80,17 +81,21 @@ public:
     ShaderProgram* reflectionProgram;
     ShaderProgram* GBufferProgram;
     ShaderProgram* localLightProgram;
+    ShaderProgram* skyProgram;
     // ShaderProgram* choelskyProgram;
-    ShaderProgram* choleskyProgram;
-    ShaderProgram* choleskyProgramV;
+    GLuint tessBlockID;         // Uniform buffer for TessBlock
     // @@ Declare additional shaders if necessary
 
 
     // Textures
     // std::string texAddress = "skys/Tropical_Beach_8k.jpg";
-    Texture *skyTex, *groundTex, *wallTex, *floorTex, *teapotTex, *frameTex, *lFrameTex, *rFrameTex;
-    Texture* wallNormal, *floorNormal, *frameNormal, *seaNormal;
-    Texture *skyIrr, *skyTex2, *skyIrr2;
+    Texture *skyTex, *skyIrr, *skyTex2, *skyIrr2;
+    GLuint skyVAO;              // Empty:  the sky pass makes its own triangle
+    TextureLoader* textureLoader;
+    MaterialTable* materials;   // Textures of everything else
+
+    // Owns the shared textures, shader programs and shapes
+    Resources* resources;
 
 
     void InitializeScene();
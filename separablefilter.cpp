@@ -0,0 +1,213 @@
+///////////////////////////////////////////////////////////////////////
+// Separable filters in compute shaders (see separablefilter.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+#include <glbinding/gl/gl.h>
+#include <glbinding/Binding.h>
+using namespace gl;
+
+#include "shader.h"
+#include "resources.h"
+#include "separablefilter.h"
+#include "moments.h"
+
+#include <glu.h>                // For gluErrorString
+#define CHECKERROR {GLenum err = glGetError(); if (err != GL_NO_ERROR) { fprintf(stderr, "OpenGL error (at line separablefilter.cpp:%d): %s\n", __LINE__, gluErrorString(err)); exit(-1);} }
+
+// Texels a group filters, as the shaders declare their sizes:  a run
+// of a row horizontally, a tile of columns vertically.
+static const int rowRun = 128;
+static const int tileColumns = 8, tileRows = 64;
+
+SeparableFilter::SeparableFilter()
+    : width(0), height(0), layers(0), format(0), radius(0), source(SOURCE_COLOR),
+      resources(NULL), horizontal(NULL), vertical(NULL), scratch(0), kernelBuffer(0), stale(true)
+{}
+
+SeparableFilter::~SeparableFilter()
+{
+    if (!resources) return;
+    resources->programs.Release(horizontal);
+    resources->programs.Release(vertical);
+    glDeleteTextures(1, &scratch);
+    glDeleteBuffers(1, &kernelBuffer);
+}
+
+void SeparableFilter::Create(Resources* _resources, const int w, const int h, const int _layers,
+                             const GLenum _format)
+{
+    if (_layers > MaxFilterLayers) {
+        printf("SeparableFilter takes %d layers at most, not %d\n", MaxFilterLayers, _layers);
+        exit(-1); }
+
+    resources = _resources;
+    width = w;
+    height = h;
+    layers = _layers;
+    format = (unsigned int)_format;
+
+    horizontal = resources->ComputeProgram("filter-h.comp", FilterSourceGLSL());
+    vertical = resources->ComputeProgram("filter-v.comp");
+    ShaderProgram* passes[] = { horizontal, vertical };
+    for (int i=0;  i<2;  i++) {
+        int loc = glGetUniformBlockIndex(passes[i]->programId, "FilterKernel");
+        glUniformBlockBinding(passes[i]->programId, loc, filterBindpoint); }
+
+    glGenTextures(1, &scratch);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, scratch);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, _format, width, height, layers);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, (int)GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, (int)GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenBuffers(1, &kernelBuffer);
+    kernel.clear();
+    SetGaussian(0);
+    CHECKERROR;
+}
+
+const char* FilterSourceGLSL()
+{
+    static const std::string prelude = std::string(MomentsGLSL) +
+        "const int SOURCE_COLOR = " + std::to_string((int)SOURCE_COLOR) +
+        ", SOURCE_MOMENTS = " + std::to_string((int)SOURCE_MOMENTS) +
+        ", SOURCE_QUANTIZED_MOMENTS = " + std::to_string((int)SOURCE_QUANTIZED_MOMENTS) + ";\n"
+        "uniform int source;\n"
+        "vec4 Texel(vec4 t)\n"
+        "{\n"
+        "    if (source == SOURCE_COLOR)\n"
+        "        return t;\n"
+        "    float z = t.x;\n"
+        "    vec4 b = vec4(z, z*z, z*z*z, z*z*z*z);\n"
+        "    return source == SOURCE_QUANTIZED_MOMENTS ? QuantizeMoments(b) : b;\n"
+        "}\n";
+    return prelude.c_str();
+}
+
+void SeparableFilter::SetGaussian(const int r)
+{
+    float weights[2*MaxFilterRadius + 1];
+    float s = r/2.0f;
+    float sum = 0.0f;
+    for (int i=0;  i<2*r+1 && i<2*MaxFilterRadius+1;  i++) {
+        weights[i] = r ? expf(-0.5f*powf((i - r)/s, 2.0f)) : 1.0f;
+        sum += weights[i]; }
+    for (int i=0;  i<2*r+1 && i<2*MaxFilterRadius+1;  i++)
+        weights[i] /= sum;
+    SetKernel(weights, r);
+}
+
+void SeparableFilter::SetKernel(const float* weights, const int r)
+{
+    if (r < 0 || r > MaxFilterRadius) {
+        printf("SeparableFilter radius %d is outside 0..%d\n", r, MaxFilterRadius);
+        exit(-1); }
+
+    // Packed as the std140 vec4 array FilterKernel declares
+    std::vector<float> packed(4*((2*MaxFilterRadius + 1 + 3)/4), 0.0f);
+    std::copy(weights, weights + 2*r + 1, packed.begin());
+    radius = r;
+    if (packed == kernel)
+        return;
+
+    kernel = packed;
+    stale = true;
+    glBindBuffer(GL_UNIFORM_BUFFER, kernelBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, kernel.size()*sizeof(float), &kernel[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void SeparableFilter::Apply(const unsigned int src, const unsigned int dst, const int* extent, const int count,
+                            const int* region)
+{
+    int size[2*MaxFilterLayers];
+    for (int i=0;  i<count;  i++)
+        size[2*i] = size[2*i+1] = extent[i];
+    Run(src, dst, size, count, region);
+}
+
+void SeparableFilter::Apply(const unsigned int src, const unsigned int dst, const int w, const int h)
+{
+    int size[2] = { w, h };
+    Run(src, dst, size, 1, NULL);
+}
+
+// Apply, with layer i over its first size[2i] x size[2i+1] texels
+void SeparableFilter::Run(const unsigned int src, const unsigned int dst, const int* size, const int count,
+                          const int* region)
+{
+    // The rectangle written in each layer, and the largest
+    int rect[4*MaxFilterLayers];
+    int w = 0, h = 0;
+    for (int i=0;  i<count;  i++) {
+        int nx = std::min(size[2*i], width), ny = std::min(size[2*i+1], height);
+        int* r = rect + 4*i;
+        if (region && !stale) {
+            r[0] = std::max(0, region[4*i]);      r[1] = std::max(0, region[4*i+1]);
+            r[2] = std::min(nx, region[4*i+2]);   r[3] = std::min(ny, region[4*i+3]); }
+        else {
+            r[0] = r[1] = 0;
+            r[2] = nx;
+            r[3] = ny; }
+        w = std::max(w, r[2] - r[0]);
+        h = std::max(h, r[3] - r[1]); }
+    stale = false;
+    if (w <= 0 || h <= 0)
+        return;
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, filterBindpoint, kernelBuffer);
+
+    Pass(horizontal, src, scratch, size, rect, count, (w + rowRun-1)/rowRun, h);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    Pass(vertical, scratch, dst, size, rect, count, (w + tileColumns-1)/tileColumns, (h + tileRows-1)/tileRows);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    CHECKERROR;
+}
+
+void SeparableFilter::Pass(ShaderProgram* program, const unsigned int src, const unsigned int dst,
+                           const int* size, const int* region, const int count, const int groupsX, const int groupsY)
+{
+    program->Use();
+    int programId = program->programId;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, src);
+    int loc = glGetUniformLocation(programId, "src");
+    glUniform1i(loc, 0);
+
+    glBindImageTexture(1, dst, 0, GL_TRUE, 0, GL_WRITE_ONLY, (GLenum)format);
+    loc = glGetUniformLocation(programId, "dst");
+    glUniform1i(loc, 1);
+
+    loc = glGetUniformLocation(programId, "w");
+    glUniform1i(loc, radius);
+
+    loc = glGetUniformLocation(programId, "source");
+    glUniform1i(loc, (int)source);
+
+    loc = glGetUniformLocation(programId, "extent");
+    glUniform2iv(loc, count, size);
+
+    loc = glGetUniformLocation(programId, "region");
+    glUniform4iv(loc, count, region);
+
+    glDispatchCompute(groupsX, groupsY, count);
+    program->Unuse();
+}
+
+size_t SeparableFilter::Bytes() const
+{
+    size_t texel = 16;
+    if (format == (unsigned int)GL_RGBA16 || format == (unsigned int)GL_RGBA16F)
+        texel = 8;
+    else if (format == (unsigned int)GL_RGBA8)
+        texel = 4;
+    return (size_t)width*height*layers*texel;
+}
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////
+// A separable filter (a blur, say) run by compute shaders over the
+// layers of a texture array:  a horizontal pass (filter-h.comp) from
+// the source into a scratch array, then a vertical pass
+// (filter-v.comp) from the scratch array into the destination, with a
+// memory barrier after each so no pass reads texels still being
+// written.
+//
+// The kernel lives in a uniform buffer, uploaded only when it changes.
+// Each layer may be filtered over just the corner of it in use (as
+// shadow cascades use), clamped at that corner's edges.  A single
+// layer may be filtered over a rectangle (as ImageOps::Gaussian
+// does).
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _SEPARABLEFILTER_
+#define _SEPARABLEFILTER_
+
+#include <vector>
+
+class Resources;
+class ShaderProgram;
+
+// Taps each side of the center;  the shaders' FilterKernel holds 101.
+const int MaxFilterRadius = 50;
+
+// Layers filtered in one Apply (extent[] in filter-h.comp)
+const int MaxFilterLayers = 4;
+
+// Uniform block binding for FilterKernel
+const int filterBindpoint = 3;
+
+// What the first pass makes of a source texel:  its color as it is,
+// or a depth (in red) turned into its four moments, as floats or
+// quantized (QuantizeMoments in moments.h).  So a shadow map can be
+// drawn as depth alone.
+enum FilterSource { SOURCE_COLOR, SOURCE_MOMENTS, SOURCE_QUANTIZED_MOMENTS };
+
+// The prelude (see ShaderProgram::AddShader) of the first passes,
+// filter-h.comp and sat-h.comp:  MomentsGLSL, FilterSource, the
+// "source" uniform, and Texel(t), the source texel t as filtered.
+const char* FilterSourceGLSL();
+
+class SeparableFilter
+{
+ public:
+    int width, height, layers;  // Of the scratch array, the most Apply takes
+    unsigned int format;        // Of the source, scratch and destination
+    int radius;                 // Of the current kernel
+    FilterSource source;        // SOURCE_COLOR unless set
+
+    SeparableFilter();
+    ~SeparableFilter();
+
+    // Build the passes (shared through resources) and the scratch
+    // array.
+    void Create(Resources* resources, const int w, const int h, const int layers,
+                const GLenum format);
+
+    // A Gaussian with radius taps each side (standard deviation
+    // radius/2), normalized.  Radius 0 copies.
+    void SetGaussian(const int radius);
+
+    // Any 2*radius+1 weights, first to last tap.
+    void SetKernel(const float* weights, const int radius);
+
+    // Filter the first count layers of src into dst (both
+    // GL_TEXTURE_2D_ARRAYs, dst of format, src of format too unless
+    // source takes depth from it), layer i over its first
+    // extent[i] texels on a side.  With region (x0, y0, x1, y1 for
+    // each layer), only texels [x0,x1) x [y0,y1) are written:  where
+    // src changed since the last Apply, grown by the radius.  Texels
+    // elsewhere are left from before, so the first Apply after a new
+    // kernel ignores region.
+    void Apply(const unsigned int src, const unsigned int dst, const int* extent, const int count,
+               const int* region=NULL);
+
+    // Filter layer 0 of src into dst over its first w x h texels.
+    void Apply(const unsigned int src, const unsigned int dst, const int w, const int h);
+
+    // Of the scratch array
+    size_t Bytes() const;
+
+ private:
+    Resources* resources;
+    ShaderProgram *horizontal, *vertical;
+    unsigned int scratch;
+    unsigned int kernelBuffer;
+    std::vector<float> kernel;  // As last uploaded
+    bool stale;                 // dst and scratch from another kernel, or none
+
+    void Run(const unsigned int src, const unsigned int dst, const int* size, const int count,
+             const int* region);
+    void Pass(ShaderProgram* program, const unsigned int src, const unsigned int dst,
+              const int* size, const int* region, const int count, const int groupsX, const int groupsY);
+};
+
+#endif
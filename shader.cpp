@@ -8,6 +8,7 @@
 ////////////////////////////////////////////////////////////////////////
 
 #include <fstream>
+#include <string>
 
 #include <glbinding/gl/gl.h>
 #include <glbinding/Binding.h>
@@ -34,11 +35,17 @@ char* ReadFile(const char* name)
 }
 
 // Creates an empty shader program.
-ShaderProgram::ShaderProgram()
+ShaderProgram::ShaderProgram() : patchProgram(NULL), positionsOnly(false)
 { 
     programId = glCreateProgram();
 }
 
+// Deletes the program (and with it any shaders attached by AddShader)
+ShaderProgram::~ShaderProgram()
+{
+    glDeleteProgram(programId);
+}
+
 // Use a shader program
 void ShaderProgram::Use()
 {
@@ -54,16 +61,22 @@ void ShaderProgram::Unuse()
 // Read, send to OpenGL, and compile a single file into a shader
 // program.  In case of an error, retrieve and print the error log
 // string.
-void ShaderProgram::AddShader(const char* fileName, GLenum type)
+void ShaderProgram::AddShader(const char* fileName, GLenum type, const char* prelude)
 {
-    // Read the source from the named file
+    // Read the source from the named file, and split off its first
+    // line for the prelude to follow
     char* src = ReadFile(fileName);
-    const char* psrc[1] = {src};
+    std::string first(src), rest;
+    size_t eol = first.find('\n');
+    if (prelude && eol != std::string::npos) {
+        rest = first.substr(eol + 1);
+        first = first.substr(0, eol + 1) + prelude + "\n#line 2\n"; }
+    const char* psrc[2] = {first.c_str(), rest.c_str()};
 
     // Create a shader and attach, hand it the source, and compile it.
     int shader = glCreateShader(type);
     glAttachShader(programId, shader);
-    glShaderSource(shader, 1, psrc, NULL);
+    glShaderSource(shader, 2, psrc, NULL);
     glCompileShader(shader);
     delete src;
 
@@ -80,6 +93,7 @@ void ShaderProgram::AddShader(const char* fileName, GLenum type)
         printf("Compile log for %s:\n%s\n", fileName, buffer);
         delete buffer;
     }
+    glDeleteShader(shader);     // Freed along with the program
 }
 
 // Link a shader program after all the shader files have been added
@@ -102,3 +116,70 @@ void ShaderProgram::LinkProgram()
         delete buffer;
     }
 }
+
+// Copy the current value of each uniform of this program into the
+// same-named uniform of dst (which must be in use), along with the
+// uniform block bindings.  This lets a companion program draw with
+// whatever a pass has already set up on this one.
+void ShaderProgram::CopyUniforms(ShaderProgram* dst)
+{
+    int count;
+    glGetProgramiv(programId, GL_ACTIVE_UNIFORMS, &count);
+    for (int i=0;  i<count;  i++) {
+        char name[256];
+        int size;
+        GLenum type;
+        glGetActiveUniform(programId, i, sizeof(name), NULL, &size, &type, name);
+
+        // Members of uniform blocks are shared through the block binding.
+        GLuint index = i;
+        int block;
+        glGetActiveUniformsiv(programId, 1, &index, GL_UNIFORM_BLOCK_INDEX, &block);
+        if (block != -1) continue;
+
+        // Arrays are reported as "name[0]";  copy them element by element.
+        std::string base(name);
+        if (size > 1)
+            base = base.substr(0, base.find('['));
+
+        for (int k=0;  k<size;  k++) {
+            std::string elem = size>1 ? base + "[" + std::to_string(k) + "]" : base;
+            int from = glGetUniformLocation(programId, elem.c_str());
+            int to = glGetUniformLocation(dst->programId, elem.c_str());
+            if (from < 0 || to < 0) continue;
+
+            float f[16];
+            int n;
+            switch (type) {
+            case GL_FLOAT:      glGetUniformfv(programId, from, f);  glUniform1fv(to, 1, f);  break;
+            case GL_FLOAT_VEC2: glGetUniformfv(programId, from, f);  glUniform2fv(to, 1, f);  break;
+            case GL_FLOAT_VEC3: glGetUniformfv(programId, from, f);  glUniform3fv(to, 1, f);  break;
+            case GL_FLOAT_VEC4: glGetUniformfv(programId, from, f);  glUniform4fv(to, 1, f);  break;
+            case GL_FLOAT_MAT3:
+                glGetUniformfv(programId, from, f);  glUniformMatrix3fv(to, 1, GL_FALSE, f);  break;
+            case GL_FLOAT_MAT4:
+                glGetUniformfv(programId, from, f);  glUniformMatrix4fv(to, 1, GL_FALSE, f);  break;
+            case GL_INT:  case GL_BOOL:
+            case GL_SAMPLER_2D:  case GL_SAMPLER_2D_ARRAY:  case GL_SAMPLER_CUBE:
+            case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+                glGetUniformiv(programId, from, &n);  glUniform1i(to, n);  break;
+            default:
+                break; } } }
+
+    glGetProgramiv(programId, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    for (int i=0;  i<count;  i++) {
+        char name[256];
+        int binding;
+        glGetActiveUniformBlockName(programId, i, sizeof(name), NULL, name);
+        glGetActiveUniformBlockiv(programId, i, GL_UNIFORM_BLOCK_BINDING, &binding);
+        GLuint loc = glGetUniformBlockIndex(dst->programId, name);
+        if (loc != GL_INVALID_INDEX)
+            glUniformBlockBinding(dst->programId, loc, binding); }
+}
+
+size_t ShaderProgram::Bytes() const
+{
+    int length = 0;
+    glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+    return length;
+}
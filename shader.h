@@ -11,10 +11,27 @@ class ShaderProgram
 {
 public:
     int programId;
+
+    // Companion program used in place of this one for shapes made of
+    // patches (which require tessellation stages).  NULL if none.
+    ShaderProgram* patchProgram;
+
+    // A depth-type pass (shadow, prepass) that reads only "vertex",
+    // bound to attribute 0:  shapes are drawn from their position-only
+    // VAOs (see Shape::DrawVAO).
+    bool positionsOnly;
     
     ShaderProgram();
-    void AddShader(const char* fileName, const GLenum type);
+    ~ShaderProgram();
+    // prelude, if any, is GLSL inserted after the file's first
+    // (#version) line;  error logs keep the file's line numbers.
+    void AddShader(const char* fileName, const GLenum type, const char* prelude=NULL);
     void LinkProgram();
     void Use();
     void Unuse();
+    void CopyUniforms(ShaderProgram* dst);
+
+    // Size of the linked program's binary, as an estimate of the
+    // memory it takes on the card.
+    size_t Bytes() const;
 };
@@ -6,14 +6,12 @@
 #version 330
 
 uniform mat4 View, Proj, ModelTr;
-uniform bool reflective;
 
 in vec4 vertex;
 
-out vec4 position;
-
+// Depth alone is drawn (no fragment shader):  its moments are taken
+// as the shadow filter reads it (see filter-h.comp).
 void main()
 {      
     gl_Position = Proj*View*ModelTr*vertex;
-    position = gl_Position;
 }
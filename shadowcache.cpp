@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////
+// Cached static shadows (see shadowcache.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <algorithm>
+
+#include <glbinding/gl/gl.h>
+#include <glbinding/Binding.h>
+using namespace gl;
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "shadowcache.h"
+
+// Empty texel rectangles
+static void Clear(int* r) { r[0] = r[1] = r[2] = r[3] = 0; }
+
+static void Union(int* r, const int* s)
+{
+    if (s[0] >= s[2]) return;
+    if (r[0] >= r[2]) {
+        std::copy(s, s+4, r);
+        return; }
+    r[0] = std::min(r[0], s[0]);  r[1] = std::min(r[1], s[1]);
+    r[2] = std::max(r[2], s[2]);  r[3] = std::max(r[3], s[3]);
+}
+
+// The texels of cascade i that item's bounding box covers.  A shape
+// without bounds (!bounded) covers the whole cascade.
+static void Footprint(const ShadowCascades& cascades, const int i, const DrawItem& item, int* r)
+{
+    int n = cascades.resolution[i];
+    Shape* shape = item.object->shape;
+    if (!shape->bounded) {
+        r[0] = r[1] = 0;
+        r[2] = r[3] = n;
+        return; }
+
+    glm::mat4 M = cascades.Matrix[i]*item.tr;
+    glm::vec2 lo(1e30f), hi(-1e30f);
+    for (int k=0;  k<8;  k++) {
+        glm::vec3 P(k&1 ? shape->maxP.x : shape->minP.x,
+                    k&2 ? shape->maxP.y : shape->minP.y,
+                    k&4 ? shape->maxP.z : shape->minP.z);
+        glm::vec2 uv = glm::vec2(M*glm::vec4(P, 1.0f))*(float)cascades.size;
+        lo = glm::min(lo, uv);
+        hi = glm::max(hi, uv); }
+
+    r[0] = std::max(0, (int)floorf(lo.x));  r[1] = std::max(0, (int)floorf(lo.y));
+    r[2] = std::min(n, (int)ceilf(hi.x));   r[3] = std::min(n, (int)ceilf(hi.y));
+    if (r[0] >= r[2] || r[1] >= r[3])
+        Clear(r);
+}
+
+ShadowCache::ShadowCache() : count(0)
+{
+    for (int i=0;  i<MaxCascades;  i++) {
+        staticDirty[i] = true;
+        Clear(region[i]);
+        Clear(footprint[i]); }
+}
+
+void ShadowCache::Create(const int w, const int h, const int layers)
+{
+    statics.CreateArrayFBO(w, h, layers, GL_DEPTH_COMPONENT32F);
+    count = 0;
+}
+
+void ShadowCache::Update(const ShadowCascades& cascades, const DrawList& list, const int margin)
+{
+    // The static casters, in order
+    std::vector<DrawItem> current;
+    for (size_t k=0;  k<list.items.size();  k++)
+        if (list.items[k].staticCaster)
+            current.push_back(list.items[k]);
+
+    bool same = current.size() == cachedStatics.size() && count == cascades.count;
+    for (size_t k=0;  same && k<current.size();  k++)
+        same = current[k].object == cachedStatics[k].object && current[k].tr == cachedStatics[k].tr;
+    cachedStatics.swap(current);
+    count = cascades.count;
+
+    for (int i=0;  i<cascades.count;  i++) {
+        int n = cascades.resolution[i];
+        staticDirty[i] = !same || cascades.Matrix[i] != matrix[i];
+        matrix[i] = cascades.Matrix[i];
+
+        int now[4];
+        Clear(now);
+        for (size_t k=0;  k<list.items.size();  k++)
+            if (!list.items[k].staticCaster) {
+                int r[4];
+                Footprint(cascades, i, list.items[k], r);
+                Union(now, r); }
+
+        if (staticDirty[i]) {
+            region[i][0] = region[i][1] = 0;
+            region[i][2] = region[i][3] = n; }
+        else {
+            std::copy(now, now+4, region[i]);
+            Union(region[i], footprint[i]);
+            if (!Clean(i)) {
+                region[i][0] = std::max(0, region[i][0] - margin);
+                region[i][1] = std::max(0, region[i][1] - margin);
+                region[i][2] = std::min(n, region[i][2] + margin);
+                region[i][3] = std::min(n, region[i][3] + margin); } }
+        std::copy(now, now+4, footprint[i]); }
+}
@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////
+// Shadow maps kept from frame to frame.  Most casters never move, and
+// the cascades move only with the light or the camera.  So the static
+// casters are drawn into a layer of their own (statics) only when
+// their cascade's projection, or the static casters themselves,
+// change.  Each frame a cascade's shadow map is restored from it,
+// and the moving casters are drawn on top.
+//
+// A cascade with no moving casters in it, this frame or last, and no
+// static change is left as it is, filtered result and all.  Otherwise
+// only region[i], where the moving casters were or are (plus the
+// filter's reach), needs filtering again.
+//
+// Nothing else invalidates the cache:  the shadow settings (the
+// quantization, the filter, summed-area tables) are compile-time
+// constants in scene.cpp, so they cannot change under it.  Making
+// any of them switchable at run time means marking every layer
+// staticDirty when it switches.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _SHADOWCACHE_
+#define _SHADOWCACHE_
+
+#include <vector>
+
+#include "fbo.h"
+#include "cascades.h"
+#include "object.h"
+
+class ShadowCache
+{
+ public:
+    FBO statics;                        // Static casters' depth, a layer a cascade
+
+    // Filled by Update
+    bool staticDirty[MaxCascades];      // statics' layer must be redrawn
+    int region[MaxCascades][4];         // Texels [x0,x1) x [y0,y1) changed;  x0 == x1 if none
+
+    ShadowCache();
+
+    void Create(const int w, const int h, const int layers);
+
+    // Compare this frame's cascades and static casters with those last
+    // drawn, and find the moving casters' footprints, grown by margin
+    // texels.
+    void Update(const ShadowCascades& cascades, const DrawList& list, const int margin);
+
+    // A region is empty
+    bool Clean(const int i) const { return region[i][0] >= region[i][2]; }
+
+ private:
+    int count;
+    glm::mat4 matrix[MaxCascades];      // As the statics were drawn
+    std::vector<DrawItem> cachedStatics;
+    int footprint[MaxCascades][4];      // Of the moving casters, last frame
+};
+
+#endif
@@ -10,7 +10,7 @@
 // position,        vec4,   attribute #0
 // normal,          vec3,   attribute #1
 // texture coord,   vec3,   attribute #2
-// tangent,         vec3,   attribute #3
+// tangent,         vec4,   attribute #3  (w: bitangent sign)
 //
 // An instance of any of these shapes is create with a single call:
 //    unsigned int obj = CreateSphere(divisions, &quadCount);
@@ -22,7 +22,10 @@
 
 #include <vector>
 #include <fstream>
+#include <thread>
+#include <algorithm>
 #include <stdlib.h>
+#include <stdarg.h>
 
 #include <glbinding/gl/gl.h>
 #include <glbinding/Binding.h>
@@ -38,12 +41,24 @@ using namespace gl;
 
 #include "math.h"
 #include "shapes.h"
-#include "rply.h"
+#include "plyfile.h"
+#include "meshcache.h"
 #include "simplexnoise.h"
 
 const float PI = 3.14159f;
 const float rad = PI/180.0f;
 
+// printf into a string, for naming MeshCache entries.
+static std::string Format(const char* format, ...)
+{
+    char buf[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return buf;
+}
+
 void pushquad(std::vector<glm::ivec3> &Tri, int i, int j, int k, int l)
 {
     Tri.push_back(glm::ivec3(i,j,k));
@@ -53,11 +68,11 @@ void pushquad(std::vector<glm::ivec3> &Tri, int i, int j, int k, int l)
 // Batch up all the data defining a shape to be drawn (example: the
 // teapot) as a Vertex Array object (VAO) and send it to the graphics
 // card.  Return an OpenGL identifier for the created VAO.
-unsigned int VaoFromTris(std::vector<glm::vec4> Pnt,
-                         std::vector<glm::vec3> Nrm,
-                         std::vector<glm::vec2> Tex,
-                         std::vector<glm::vec3> Tan,
-                         std::vector<glm::ivec3> Tri)
+unsigned int VaoFromTris(const std::vector<glm::vec4>& Pnt,
+                         const std::vector<glm::vec3>& Nrm,
+                         const std::vector<glm::vec2>& Tex,
+                         const std::vector<glm::vec4>& Tan,
+                         const std::vector<glm::ivec3>& Tri)
 {
     printf("VaoFromTris %ld %ld\n", Pnt.size(), Tri.size());
     unsigned int vaoID;
@@ -97,10 +112,10 @@ unsigned int VaoFromTris(std::vector<glm::vec4> Pnt,
         GLuint Dbuff;
         glGenBuffers(1, &Dbuff);
         glBindBuffer(GL_ARRAY_BUFFER, Dbuff);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float)*3*Tan.size(),
+        glBufferData(GL_ARRAY_BUFFER, sizeof(float)*4*Tan.size(),
                      &Tan[0][0], GL_STATIC_DRAW);
         glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 0, 0);
         glBindBuffer(GL_ARRAY_BUFFER, 0); }
 
     GLuint Ibuff;
@@ -123,7 +138,14 @@ void Shape::ComputeSize()
         for (int c=0;  c<3;  c++) {
             minP[c] = std::min(minP[c], (*p)[c]);
             maxP[c] = std::max(maxP[c], (*p)[c]); }
-    
+    bounded = true;
+
+    ComputeTransform();
+}
+
+// Center, size and modelTr from minP and maxP.
+void Shape::ComputeTransform()
+{
     center = (maxP+minP)/2.0f;
     size = 0.0;
     for (int c=0;  c<3;  c++)
@@ -133,16 +155,217 @@ void Shape::ComputeSize()
     modelTr = Scale(s,s,s)*Translate(-center[0], -center[1], -center[2]);
 }
 
+// The buffers a VAO reads:  its vertex attributes and its indices.
+static std::vector<GLuint> VaoBuffers(const unsigned int vaoID)
+{
+    std::vector<GLuint> buffers;
+    int attribs, buffer;
+    glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &attribs);
+    glBindVertexArray(vaoID);
+    for (int i=0;  i<attribs;  i++) {
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &buffer);
+        if (buffer) buffers.push_back(buffer); }
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &buffer);
+    if (buffer) buffers.push_back(buffer);
+    glBindVertexArray(0);
+    return buffers;
+}
+
+// A VAO reading only vaoID's position buffer (attribute 0), through
+// the same indices, so a depth pass fetches 16 bytes a vertex in the
+// main pass's index order.
+static unsigned int PositionVao(const unsigned int vaoID)
+{
+    int position, indices;
+    glBindVertexArray(vaoID);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &position);
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &indices);
+
+    unsigned int positionVaoID;
+    glGenVertexArrays(1, &positionVaoID);
+    glBindVertexArray(positionVaoID);
+    glBindBuffer(GL_ARRAY_BUFFER, position);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices);
+    glBindVertexArray(0);
+    return positionVaoID;
+}
+
+Shape::~Shape()
+{
+    if (!vaoID) return;
+    std::vector<GLuint> buffers = VaoBuffers(vaoID);
+    if (positionVaoID)
+        glDeleteVertexArrays(1, &positionVaoID);
+    glDeleteVertexArrays(1, &vaoID);
+    if (!buffers.empty())
+        glDeleteBuffers(buffers.size(), &buffers[0]);
+}
+
+size_t Shape::Bytes() const
+{
+    if (!vaoID) return 0;
+    std::vector<GLuint> buffers = VaoBuffers(vaoID);
+    size_t total = 0;
+    int size;
+    for (size_t i=0;  i<buffers.size();  i++) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffers[i]);
+        glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+        total += size; }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return total;
+}
+
 void Shape::MakeVAO()
 {
     vaoID = VaoFromTris(Pnt, Nrm, Tex, Tan, Tri);
     count = Tri.size();
 }
 
-void Shape::DrawVAO()
+////////////////////////////////////////////////////////////////////////
+// Tangent frames from texture coordinates, as MikkTSpace builds them.
+// Each triangle's texture-space s and t directions are projected into
+// the tangent plane at each corner, normalized, and summed weighted by
+// the corner angle.  The summed s direction, orthonormalized against
+// the vertex normal, is the tangent, and w is the sign for which
+// w*cross(N,T) follows the t direction.
+//
+// Triangle directions are found in parallel over triangle ranges;  the
+// sums are then made in parallel over vertex ranges, each thread adding
+// only into the vertices it owns, reached through a list of each
+// vertex's triangle corners (Corners).  No locking is needed, and each
+// vertex sums its triangles in the same order for any thread count.
+
+// Texture-space directions and corner angles of one triangle
+struct TriangleFrame
+{
+    glm::vec3 s, t;
+    glm::vec3 angle;
+};
+
+// Call f(begin, end) over [0,n) split into ranges of at least grain
+// items, one range per hardware thread.
+template<class F> static void ParallelRanges(const size_t n, const size_t grain, F f)
+{
+    size_t threads = std::thread::hardware_concurrency();
+    threads = std::max((size_t)1, std::min(threads, n/grain));
+    size_t step = (n + threads-1)/threads;
+
+    std::vector<std::thread> workers;
+    for (size_t i=step;  i<n;  i+=step)
+        workers.push_back(std::thread(f, i, std::min(n, i+step)));
+    f((size_t)0, std::min(n, step));
+    for (size_t i=0;  i<workers.size();  i++)
+        workers[i].join();
+}
+
+static float CornerAngle(const glm::vec3& a, const glm::vec3& b)
+{
+    float la = glm::length(a), lb = glm::length(b);
+    if (la == 0.0f || lb == 0.0f) return 0.0f;
+    return acos(glm::clamp(glm::dot(a, b)/(la*lb), -1.0f, 1.0f));
+}
+
+static void TriangleFrames(const Shape* shape, TriangleFrame* F, size_t begin, size_t end)
+{
+    for (size_t t=begin;  t<end;  t++) {
+        const glm::ivec3& tri = shape->Tri[t];
+        glm::vec3 P0 = shape->Pnt[tri[0]].xyz();
+        glm::vec3 P1 = shape->Pnt[tri[1]].xyz();
+        glm::vec3 P2 = shape->Pnt[tri[2]].xyz();
+        glm::vec3 E1 = P1-P0, E2 = P2-P0;
+        glm::vec2 D1 = shape->Tex[tri[1]] - shape->Tex[tri[0]];
+        glm::vec2 D2 = shape->Tex[tri[2]] - shape->Tex[tri[0]];
+
+        TriangleFrame& f = F[t];
+        f.angle = glm::vec3(CornerAngle(E1, E2), CornerAngle(P2-P1, P0-P1), CornerAngle(P0-P2, P1-P2));
+
+        // A triangle with no texture area says nothing about direction.
+        float det = D1.x*D2.y - D2.x*D1.y;
+        if (fabs(det) < 1e-20f) {
+            f.s = f.t = glm::vec3(0.0f);
+            continue; }
+        f.s = (E1*D2.y - E2*D1.y)/det;
+        f.t = (E2*D1.x - E1*D2.x)/det; }
+}
+
+// The part of d perpendicular to N, normalized (or zero).
+static glm::vec3 Perpendicular(const glm::vec3& d, const glm::vec3& N)
+{
+    glm::vec3 p = d - N*glm::dot(N, d);
+    float l = glm::length(p);
+    return l > 1e-20f ? p/l : glm::vec3(0.0f);
+}
+
+// The triangle corners (3*t + c) at each vertex, in order of t:
+// vertex v's are corner[first[v]] to corner[first[v+1]-1].
+struct Corners
+{
+    std::vector<unsigned int> first, corner;
+
+    Corners(const Shape* shape) : first(shape->Pnt.size()+1, 0), corner(3*shape->Tri.size())
+    {
+        for (size_t t=0;  t<shape->Tri.size();  t++)
+            for (int c=0;  c<3;  c++)
+                first[shape->Tri[t][c] + 1]++;
+        for (size_t v=0;  v<shape->Pnt.size();  v++)
+            first[v+1] += first[v];
+        std::vector<unsigned int> next(first.begin(), first.end()-1);
+        for (size_t t=0;  t<shape->Tri.size();  t++)
+            for (int c=0;  c<3;  c++)
+                corner[next[shape->Tri[t][c]]++] = 3*t + c;
+    }
+};
+
+static void VertexFrames(Shape* shape, const TriangleFrame* F, const Corners& corners,
+                         size_t begin, size_t end)
+{
+    for (size_t v=begin;  v<end;  v++) {
+        // A zero normal would normalize to NaN;  it gets the arbitrary
+        // frame below instead.
+        const glm::vec3& n = shape->Nrm[v];
+        const glm::vec3 N = glm::dot(n, n) > 0.0f ? glm::normalize(n) : glm::vec3(0.0f);
+        glm::vec3 S(0.0f), T(0.0f);
+        for (unsigned int k=corners.first[v];  k<corners.first[v+1];  k++) {
+            unsigned int t = corners.corner[k]/3, c = corners.corner[k]%3;
+            if (F[t].angle[c] == 0.0f) continue;
+            S += F[t].angle[c]*Perpendicular(F[t].s, N);
+            T += F[t].angle[c]*Perpendicular(F[t].t, N); }
+
+        glm::vec3 Tan = Perpendicular(S, N);
+
+        // No usable texture direction:  any unit vector in the plane will do.
+        if (Tan == glm::vec3(0.0f))
+            Tan = Perpendicular(fabs(N.x) < 0.9f ? glm::vec3(1,0,0) : glm::vec3(0,1,0), N);
+
+        float w = glm::dot(glm::cross(N, Tan), T) < 0.0f ? -1.0f : 1.0f;
+        shape->Tan[v] = glm::vec4(Tan, w); }
+}
+
+void Shape::ComputeTangents()
+{
+    Tan.assign(Pnt.size(), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+    if (Tex.size() != Pnt.size() || Nrm.size() != Pnt.size() || Pnt.empty())
+        return;
+
+    std::vector<TriangleFrame> F(Tri.size());
+    TriangleFrame* f = F.data();
+    Shape* shape = this;
+
+    ParallelRanges(Tri.size(), 4096, [shape, f](size_t b, size_t e) { TriangleFrames(shape, f, b, e); });
+    Corners corners(shape);
+    const Corners* c = &corners;
+    ParallelRanges(Pnt.size(), 4096, [shape, f, c](size_t b, size_t e) { VertexFrames(shape, f, *c, b, e); });
+}
+
+void Shape::DrawVAO(const bool positionsOnly)
 {
     CHECKERROR;
-    glBindVertexArray(vaoID);
+    if (positionsOnly && !positionVaoID)
+        positionVaoID = PositionVao(vaoID);
+    glBindVertexArray(positionsOnly ? positionVaoID : vaoID);
     CHECKERROR;
     glDrawElements(GL_TRIANGLES, 3*count, GL_UNSIGNED_INT, 0);
     CHECKERROR;
@@ -301,6 +524,73 @@ glm::vec3 TeapotPoints[] = {
     glm::vec3(0.84,-1.5,0.075), glm::vec3(1.5,-0.84,0.075), glm::vec3(0.798,-1.425,0.0),
     glm::vec3(1.425,-0.798,0.0)};
 
+////////////////////////////////////////////////////////////////////////////////
+// Evaluates teapot patch p at (u,v).  Returns the surface point, and
+// the u and v tangents in du and dv.
+glm::vec3 TeapotPatchPoint(const int p, const float u, const float v,
+                           glm::vec3& du, glm::vec3& dv)
+{
+    // Four u weights
+    float u0 = (1.0-u)*(1.0-u)*(1.0-u);
+    float u1 = 3.0*(1.0-u)*(1.0-u)*u;
+    float u2 = 3.0*(1.0-u)*u*u;
+    float u3 = u*u*u;
+
+    // Three du weights
+    float du0 = (1.0-u)*(1.0-u);
+    float du1 = 2.0*(1.0-u)*u;
+    float du2 = u*u;
+
+    // Four v weights
+    float v0 = (1.0-v)*(1.0-v)*(1.0-v);
+    float v1 = 3.0*(1.0-v)*(1.0-v)*v;
+    float v2 = 3.0*(1.0-v)*v*v;
+    float v3 = v*v*v;
+
+    // Three dv weights
+    float dv0 = (1.0-v)*(1.0-v);
+    float dv1 = 2.0*(1.0-v)*v;
+    float dv2 = v*v;
+
+    // Grab the 16 control points for Bezier patch.
+    glm::vec3* p00 = &TeapotPoints[TeapotIndex[p][ 0]-1];
+    glm::vec3* p01 = &TeapotPoints[TeapotIndex[p][ 1]-1];
+    glm::vec3* p02 = &TeapotPoints[TeapotIndex[p][ 2]-1];
+    glm::vec3* p03 = &TeapotPoints[TeapotIndex[p][ 3]-1];
+    glm::vec3* p10 = &TeapotPoints[TeapotIndex[p][ 4]-1];
+    glm::vec3* p11 = &TeapotPoints[TeapotIndex[p][ 5]-1];
+    glm::vec3* p12 = &TeapotPoints[TeapotIndex[p][ 6]-1];
+    glm::vec3* p13 = &TeapotPoints[TeapotIndex[p][ 7]-1];
+    glm::vec3* p20 = &TeapotPoints[TeapotIndex[p][ 8]-1];
+    glm::vec3* p21 = &TeapotPoints[TeapotIndex[p][ 9]-1];
+    glm::vec3* p22 = &TeapotPoints[TeapotIndex[p][10]-1];
+    glm::vec3* p23 = &TeapotPoints[TeapotIndex[p][11]-1];
+    glm::vec3* p30 = &TeapotPoints[TeapotIndex[p][12]-1];
+    glm::vec3* p31 = &TeapotPoints[TeapotIndex[p][13]-1];
+    glm::vec3* p32 = &TeapotPoints[TeapotIndex[p][14]-1];
+    glm::vec3* p33 = &TeapotPoints[TeapotIndex[p][15]-1];
+
+    // Evaluate the u-tangent of the Bezier patch at (u,v)
+    du =
+        du0*v0*(*p10-*p00) + du0*v1*(*p11-*p01) + du0*v2*(*p12-*p02) + du0*v3*(*p13-*p03) +
+        du1*v0*(*p20-*p10) + du1*v1*(*p21-*p11) + du1*v2*(*p22-*p12) + du1*v3*(*p23-*p13) +
+        du2*v0*(*p30-*p20) + du2*v1*(*p31-*p21) + du2*v2*(*p32-*p22) + du2*v3*(*p33-*p23);
+
+    // Evaluate the v-tangent of the Bezier patch at (u,v)
+    dv =
+        u0*dv0*(*p01-*p00) + u0*dv1*(*p02-*p01) + u0*dv2*(*p03-*p02) +
+        u1*dv0*(*p11-*p10) + u1*dv1*(*p12-*p11) + u1*dv2*(*p13-*p12) +
+        u2*dv0*(*p21-*p20) + u2*dv1*(*p22-*p21) + u2*dv2*(*p23-*p22) +
+        u3*dv0*(*p31-*p30) + u3*dv1*(*p32-*p31) + u3*dv2*(*p33-*p32);
+
+    // Evaluate the Bezier patch at (u,v)
+    return
+        u0*v0*(*p00) + u0*v1*(*p01) + u0*v2*(*p02) + u0*v3*(*p03) +
+        u1*v0*(*p10) + u1*v1*(*p11) + u1*v2*(*p12) + u1*v3*(*p13) +
+        u2*v0*(*p20) + u2*v1*(*p21) + u2*v2*(*p22) + u2*v3*(*p23) +
+        u3*v0*(*p30) + u3*v1*(*p31) + u3*v2*(*p32) + u3*v3*(*p33);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Builds a Vertex Array Object for the Utah teapot.  Each of the 32
 // patches is represented by an n by n grid of quads triangulated.
@@ -311,6 +601,12 @@ Teapot::Teapot(const int n)
     shininess = 120.0;
     animate = true;
 
+    MeshCache cache(Format("teapot-%d", n), Format("Teapot n=%d", n));
+    if (cache.Load(this)) {
+        ComputeTransform();
+        MakeVAO();
+        return; }
+
     int npatches = sizeof(TeapotIndex)/sizeof(TeapotIndex[0]); // Should be 32 patches for the teapot
     const int nv = npatches*(n+1)*(n+1);
     int nq = npatches*n*n;
@@ -321,77 +617,15 @@ Teapot::Teapot(const int n)
             for (int j=0;  j<=n; j++) { // Grid if v direction
                 float v = float(j)/n;
 
-                // Four u weights
-                float u0 = (1.0-u)*(1.0-u)*(1.0-u);
-                float u1 = 3.0*(1.0-u)*(1.0-u)*u;
-                float u2 = 3.0*(1.0-u)*u*u;
-                float u3 = u*u*u;
-
-                // Three du weights
-                float du0 = (1.0-u)*(1.0-u);
-                float du1 = 2.0*(1.0-u)*u;
-                float du2 = u*u;
-
-                // Four v weights
-                float v0 = (1.0-v)*(1.0-v)*(1.0-v);
-                float v1 = 3.0*(1.0-v)*(1.0-v)*v;
-                float v2 = 3.0*(1.0-v)*v*v;
-                float v3 = v*v*v;
-
-                // Three dv weights
-                float dv0 = (1.0-v)*(1.0-v);
-                float dv1 = 2.0*(1.0-v)*v;
-                float dv2 = v*v;
-
-                // Grab the 16 control points for Bezier patch.
-                glm::vec3* p00 = &TeapotPoints[TeapotIndex[p][ 0]-1];
-                glm::vec3* p01 = &TeapotPoints[TeapotIndex[p][ 1]-1];
-                glm::vec3* p02 = &TeapotPoints[TeapotIndex[p][ 2]-1];
-                glm::vec3* p03 = &TeapotPoints[TeapotIndex[p][ 3]-1];
-                glm::vec3* p10 = &TeapotPoints[TeapotIndex[p][ 4]-1];
-                glm::vec3* p11 = &TeapotPoints[TeapotIndex[p][ 5]-1];
-                glm::vec3* p12 = &TeapotPoints[TeapotIndex[p][ 6]-1];
-                glm::vec3* p13 = &TeapotPoints[TeapotIndex[p][ 7]-1];
-                glm::vec3* p20 = &TeapotPoints[TeapotIndex[p][ 8]-1];
-                glm::vec3* p21 = &TeapotPoints[TeapotIndex[p][ 9]-1];
-                glm::vec3* p22 = &TeapotPoints[TeapotIndex[p][10]-1];
-                glm::vec3* p23 = &TeapotPoints[TeapotIndex[p][11]-1];
-                glm::vec3* p30 = &TeapotPoints[TeapotIndex[p][12]-1];
-                glm::vec3* p31 = &TeapotPoints[TeapotIndex[p][13]-1];
-                glm::vec3* p32 = &TeapotPoints[TeapotIndex[p][14]-1];
-                glm::vec3* p33 = &TeapotPoints[TeapotIndex[p][15]-1];
-
-                // Evaluate the Bezier patch at (u,v)
-                glm::vec3 V =
-                    u0*v0*(*p00) + u0*v1*(*p01) + u0*v2*(*p02) + u0*v3*(*p03) +
-                    u1*v0*(*p10) + u1*v1*(*p11) + u1*v2*(*p12) + u1*v3*(*p13) +
-                    u2*v0*(*p20) + u2*v1*(*p21) + u2*v2*(*p22) + u2*v3*(*p23) +
-                    u3*v0*(*p30) + u3*v1*(*p31) + u3*v2*(*p32) + u3*v3*(*p33);
-                //*pp++ = glm::vec4(V[0], V[1], V[2], 1.0);
+                glm::vec3 du, dv;
+                glm::vec3 V = TeapotPatchPoint(p, u, v, du, dv);
                 Pnt.push_back(glm::vec4(V[0], V[1], V[2], 1.0));
                 Tex.push_back(glm::vec2(u,v));
-
-                // Evaluate the u-tangent of the Bezier patch at (u,v)
-                glm::vec3 du =
-                    du0*v0*(*p10-*p00) + du0*v1*(*p11-*p01) + du0*v2*(*p12-*p02) + du0*v3*(*p13-*p03) +
-                    du1*v0*(*p20-*p10) + du1*v1*(*p21-*p11) + du1*v2*(*p22-*p12) + du1*v3*(*p23-*p13) +
-                    du2*v0*(*p30-*p20) + du2*v1*(*p31-*p21) + du2*v2*(*p32-*p22) + du2*v3*(*p33-*p23);
-                Tan.push_back(du);
-
-                // Evaluate the v-tangent of the Bezier patch at (u,v)
-                glm::vec3 dv =
-                    u0*dv0*(*p01-*p00) + u0*dv1*(*p02-*p01) + u0*dv2*(*p03-*p02) +
-                    u1*dv0*(*p11-*p10) + u1*dv1*(*p12-*p11) + u1*dv2*(*p13-*p12) +
-                    u2*dv0*(*p21-*p20) + u2*dv1*(*p22-*p21) + u2*dv2*(*p23-*p22) +
-                    u3*dv0*(*p31-*p30) + u3*dv1*(*p32-*p31) + u3*dv2*(*p33-*p32);
+                Tan.push_back(glm::vec4(du, -1.0f));
 
                 // Calculate the surface normal as the cross product of the two tangents.
                 Nrm.push_back(glm::cross(dv,du));
 
-                //-(du[1]*dv[2]-du[2]*dv[1]);
-                //*np++ = -(du[2]*dv[0]-du[0]*dv[2]);
-                //*np++ = -(du[0]*dv[1]-du[1]*dv[0]);
-
                 // Create a quad for all but the first edge vertices
                 if (i>0 && j>0) 
                     pushquad(Tri,
@@ -399,10 +633,88 @@ Teapot::Teapot(const int n)
                              p*(n+1)*(n+1) + (i-1)*(n+1) + (j),
                              p*(n+1)*(n+1) + (i  )*(n+1) + (j),
                              p*(n+1)*(n+1) + (i  )*(n+1) + (j-1)); } } }
+    cache.Save(this);
+    ComputeTransform();
+    MakeVAO();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Builds a VAO containing only the teapot's 306 control points and its
+// 32 patches of 16 (0-based) indices each.  The surface is evaluated on
+// the GPU by teapot.tese at a level of detail chosen per edge by
+// teapot.tesc.
+TeapotPatches::TeapotPatches()
+{
+    diffuseColor = glm::vec3(0.5, 0.5, 0.1);
+    specularColor = glm::vec3(1.0, 1.0, 1.0);
+    shininess = 120.0;
+    animate = true;
+    patches = true;
+
+    int npatches = sizeof(TeapotIndex)/sizeof(TeapotIndex[0]);
+    int npoints = sizeof(TeapotPoints)/sizeof(TeapotPoints[0]);
+
+    // The control net extends past the surface (at the handle and
+    // spout), so size the shape from the surface itself, sampled on the
+    // same 12x12 grid as the full-polygon CPU teapot.  This keeps modelTr
+    // identical between the two paths.
+    const int n = 12;
+    for (int p=0;  p<npatches;  p++)
+        for (int i=0;  i<=n; i++)
+            for (int j=0;  j<=n; j++) {
+                glm::vec3 du, dv;
+                glm::vec3 V = TeapotPatchPoint(p, float(i)/n, float(j)/n, du, dv);
+                Pnt.push_back(glm::vec4(V[0], V[1], V[2], 1.0)); }
     ComputeSize();
+
+    Pnt.clear();
+    for (int i=0;  i<npoints;  i++)
+        Pnt.push_back(glm::vec4(TeapotPoints[i], 1.0));
+
+    for (int p=0;  p<npatches;  p++)
+        for (int k=0;  k<16;  k++)
+            PatchIdx.push_back(TeapotIndex[p][k]-1);
+
     MakeVAO();
 }
 
+void TeapotPatches::MakeVAO()
+{
+    printf("VaoFromPatches %ld %ld\n", Pnt.size(), PatchIdx.size()/16);
+    glGenVertexArrays(1, &vaoID);
+    glBindVertexArray(vaoID);
+
+    GLuint Pbuff;
+    glGenBuffers(1, &Pbuff);
+    glBindBuffer(GL_ARRAY_BUFFER, Pbuff);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float)*4*Pnt.size(),
+                 &Pnt[0][0], GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLuint Ibuff;
+    glGenBuffers(1, &Ibuff);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Ibuff);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int)*PatchIdx.size(),
+                 &PatchIdx[0], GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    count = PatchIdx.size();
+}
+
+// The control points are the only attribute, so positionsOnly changes
+// nothing.
+void TeapotPatches::DrawVAO(const bool /*positionsOnly*/)
+{
+    CHECKERROR;
+    glBindVertexArray(vaoID);
+    glPatchParameteri(GL_PATCH_VERTICES, 16);
+    glDrawElements(GL_PATCHES, count, GL_UNSIGNED_INT, 0);
+    CHECKERROR;
+    glBindVertexArray(0);
+}
+
 
 ////////////////////////////////////////////////////////////////////////
 // Generates a box +-1 on all axes
@@ -440,7 +752,7 @@ void Box::face(const glm::mat4 tr)
       Pnt.push_back(tr*glm::vec4(verts[i], verts[i+1], 1.0f, 1.0f));
       Nrm.push_back(glm::vec3(tr*glm::vec4(0.0f, 0.0f, 1.0f, 0.0f)));
       Tex.push_back(glm::vec2(texcd[i], texcd[i+1]));
-      Tan.push_back(glm::vec3(tr*glm::vec4(1.0f, 0.0f, 0.0f, 0.0f))); }
+      Tan.push_back(glm::vec4(glm::vec3(tr*glm::vec4(1.0f, 0.0f, 0.0f, 0.0f)), 1.0f)); }
     
   pushquad(Tri, n, n+1, n+2, n+3);
 }
@@ -455,6 +767,12 @@ Sphere::Sphere(const int n)
     specularColor = glm::vec3(1.0, 1.0, 1.0);
     shininess = 120.0;
 
+    MeshCache cache(Format("sphere-%d", n), Format("Sphere n=%d", n));
+    if (cache.Load(this)) {
+        ComputeTransform();
+        MakeVAO();
+        return; }
+
     float d = 2.0f*PI/float(n*2);
     for (int i=0;  i<=n*2;  i++) {
         float s = i*2.0f*PI/float(n*2);
@@ -466,13 +784,14 @@ Sphere::Sphere(const int n)
             Pnt.push_back(glm::vec4(x,y,z,1.0f));
             Nrm.push_back(glm::vec3(x,y,z));
             Tex.push_back(glm::vec2(s/(2*PI), t/PI));
-            Tan.push_back(glm::vec3(-sin(s), cos(s), 0.0));
+            Tan.push_back(glm::vec4(-sin(s), cos(s), 0.0, -1.0));
             if (i>0 && j>0) {
                 pushquad(Tri, (i-1)*(n+1) + (j-1),
                                       (i-1)*(n+1) + (j),
                                       (i  )*(n+1) + (j),
                                       (i  )*(n+1) + (j-1)); } } }
-    ComputeSize();
+    cache.Save(this);
+    ComputeTransform();
     MakeVAO();
 }
 
@@ -489,7 +808,7 @@ Disk::Disk(const int n)
     Pnt.push_back(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
     Nrm.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
     Tex.push_back(glm::vec2(0.5, 0.5));
-    Tan.push_back(glm::vec3(1.0f, 0.0f, 0.0f));
+    Tan.push_back(glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
 
     float d = 2.0f*PI/float(n);
     for (int i=0;  i<=n;  i++) {
@@ -499,7 +818,7 @@ Disk::Disk(const int n)
         Pnt.push_back(glm::vec4(x,y,0.0f,1.0f));
         Nrm.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
         Tex.push_back(glm::vec2(x*0.5+0.5, y*0.5+0.5));
-        Tan.push_back(glm::vec3(1.0f, 0.0f, 0.0f));
+        Tan.push_back(glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
         if (i>0) {
           Tri.push_back(glm::ivec3(0, i+1, i)); } }
     ComputeSize();
@@ -526,7 +845,7 @@ Cylinder::Cylinder(const int n)
             Pnt.push_back(glm::vec4(x,y,z,1.0f));
             Nrm.push_back(glm::vec3(x,y, 0.0f));
             Tex.push_back(glm::vec2(s/(2.0*PI), t));
-            Tan.push_back(glm::vec3(-sin(s), cos(s), 0.0));
+            Tan.push_back(glm::vec4(-sin(s), cos(s), 0.0, 1.0));
             if (i>0 && j>0) {
                 pushquad(Tri, (i-1)*(2) + (j-1),
                                       (i-1)*(2) + (j),
@@ -537,125 +856,30 @@ Cylinder::Cylinder(const int n)
 }
 
 ////////////////////////////////////////////////////////////////////////
-// Generates a plane with normals, texture coords, and tangent vectors
-// from an n by n grid of small quads.  A single quad might have been
-// sufficient, but that works poorly with the reflection map.
+// Reads a polygonal model from a PLY file (see plyfile.cpp).
 Ply::Ply(const char* name, const bool reverse)
 {
     diffuseColor = glm::vec3(0.8, 0.8, 0.5);
     specularColor = glm::vec3(1.0, 1.0, 1.0);
     shininess = 120.0;
 
-    // Open PLY file and read header;  Exit on any failure.
-    p_ply ply = ply_open(name, NULL, 0, NULL);
-    if (!ply) { throw std::exception(); }
-    if (!ply_read_header(ply)) { throw std::exception(); }
-
-    // Setup callback for vertices
-    ply_set_read_cb(ply, "vertex", "x", vertex_cb, this, 0);
-    ply_set_read_cb(ply, "vertex", "y", vertex_cb, this, 1);
-    ply_set_read_cb(ply, "vertex", "z", vertex_cb, this, 2);
-
-    ply_set_read_cb(ply, "vertex", "nx", normal_cb, this, 0);
-    ply_set_read_cb(ply, "vertex", "ny", normal_cb, this, 1);
-    ply_set_read_cb(ply, "vertex", "nz", normal_cb, this, 2);
-
-    ply_set_read_cb(ply, "vertex", "s", texture_cb, this, 0);
-    ply_set_read_cb(ply, "vertex", "t", texture_cb, this, 1);
-
-    // Setup callback for faces
-    ply_set_read_cb(ply, "face", "vertex_indices", face_cb, this, 0);
-
-    // Read the PLY file filling the arrays via the callbacks.
-    if (!ply_read(ply)) {printf("Failure in ply_read\n"); exit(-1); }
-
-    ComputeSize();
+    // The cache entry is keyed by the file's contents, so an edited
+    // model is reread.
+    std::string file(name);
+    for (size_t i=0;  i<file.size();  i++)
+        if (file[i] == '/' || file[i] == '\\' || file[i] == ':') file[i] = '_';
+    MeshCache cache("ply-" + file, Format("Ply %s reverse=%d hash=%s", name, reverse,
+                                          MeshCache::FileHash(name).c_str()));
+
+    if (!cache.Load(this)) {
+        // Read the PLY file straight into the data arrays;  Exit on any failure.
+        if (!ReadPly(name, this)) { throw std::exception(); }
+        ComputeTangents();
+        cache.Save(this); }
+
+    ComputeTransform();
     MakeVAO();
 }
- 
-
-glm::vec4 staticPnt;
-glm::vec3 staticNrm;
-glm::vec2 staticTex;
-glm::ivec3 staticTri;
-
-// Vertex callback;  Must be static (stupid C++)
-int Ply::vertex_cb(p_ply_argument argument) {
-    long index;
-    Ply *ply;
-    ply_get_argument_user_data(argument, (void**)&ply, &index);
-    double c = ply_get_argument_value(argument);
-    staticPnt[index] = c;
-    if (index==2) {
-        staticPnt[3] = 1.0;
-        ply->Pnt.push_back(staticPnt);
-        ply->Tan.push_back(glm::vec3()); }
-    return 1;
-}
-// Normal callback;  Must be static (stupid C++)
-int Ply::normal_cb(p_ply_argument argument) {
-    long index;
-    Ply *ply;
-    ply_get_argument_user_data(argument, (void**)&ply, &index);
-    double c = ply_get_argument_value(argument);
-    staticNrm[index] = c;
-    if (index==2) {
-        ply->Nrm.push_back(staticNrm); }
-    return 1;
-}
-// Texture callback;  Must be static (stupid C++)
-int Ply::texture_cb(p_ply_argument argument) {
-    long index;
-    Ply *ply;
-    ply_get_argument_user_data(argument, (void**)&ply, &index);
-    double c = ply_get_argument_value(argument);
-    staticTex[index] = c;
-    if (index==1) {
-        ply->Tex.push_back(staticTex); }
-    return 1;
-}
-
-void ComputeTangent(Ply* ply)
-{
-    int t = ply->Tri.size() - 1;
-    int i = ply->Tri[t][0];
-    int j = ply->Tri[t][1];
-    int k = ply->Tri[t][2];
-    glm::vec2 A = ply->Tex[i] - ply->Tex[k]; 
-    glm::vec2 B = ply->Tex[j] - ply->Tex[k];
-    float d = A[0]*B[1] - A[1]*B[0];
-    float a =  B[1]/d;
-    float b = -A[1]/d;
-    glm::vec4 Tan = a*ply->Pnt[i] + b*ply->Pnt[j] + (1.0f-a-b)*ply->Pnt[k];
-    ply->Tan[i] = ply->Tan[j] = ply->Tan[k] = glm::normalize(Tan.xyz());
-    
-}
-
-// Face callback;  Must be static (stupid C++)
-int Ply::face_cb(p_ply_argument argument) {
-    long length, value_index;
-    long index;
-    Ply *ply;
-    ply_get_argument_user_data(argument, (void**)&ply, &index);
-    ply_get_argument_property(argument, NULL, &length, &value_index);
-
-    if (value_index == -1) {
-    }
-    else {
-        if (value_index<2) {
-            staticTri[value_index] = (int)ply_get_argument_value(argument); }
-        else if (value_index==2) {
-            staticTri[2] = (int)ply_get_argument_value(argument);
-            ply->Tri.push_back(staticTri);
-            ComputeTangent(ply); }
-        else if (value_index==3) {
-            staticTri[1] = staticTri[2];
-            staticTri[2] = (int)ply_get_argument_value(argument);
-            ply->Tri.push_back(staticTri);
-            ComputeTangent(ply); } }
-
-    return 1;
-}
 
 ////////////////////////////////////////////////////////////////////////
 // Generates a plane with normals, texture coords, and tangent vectors
@@ -667,6 +891,12 @@ Plane::Plane(const float r, const int n)
     specularColor = glm::vec3(1.0, 1.0, 1.0);
     shininess = 120.0;
 
+    MeshCache cache(Format("plane-%g-%d", r, n), Format("Plane r=%.9g n=%d", r, n));
+    if (cache.Load(this)) {
+        ComputeSize();
+        MakeVAO();
+        return; }
+
     for (int i=0;  i<=n;  i++) {
         float s = i/float(n);
         for (int j=0;  j<=n;  j++) {
@@ -674,17 +904,22 @@ Plane::Plane(const float r, const int n)
             Pnt.push_back(glm::vec4(s*2.0*r-r, t*2.0*r-r, 0.0, 1.0));
             Nrm.push_back(glm::vec3(0.0, 0.0, 1.0));
             Tex.push_back(glm::vec2(s, t));
-            Tan.push_back(glm::vec3(1.0, 0.0, 0.0));
+            Tan.push_back(glm::vec4(1.0, 0.0, 0.0, 1.0));
             if (i>0 && j>0) {
                 pushquad(Tri, (i-1)*(n+1) + (j-1),
                                       (i-1)*(n+1) + (j),
                                       (i  )*(n+1) + (j),
                                       (i  )*(n+1) + (j-1)); } } }
 
-    vaoID = VaoFromTris(Pnt, Nrm, Tex, Tan, Tri);
-    count = Tri.size();
+    cache.Save(this);
+    ComputeSize();
+    MakeVAO();
 }
 
+// Where in the noise the terrain is taken from.  Fixed, so every run
+// builds the same terrain, and finds it in the mesh cache.
+static const int groundSeed = 217;
+
 ////////////////////////////////////////////////////////////////////////
 // Generates a plane with normals, texture coords, and tangent vectors
 // from an n by n grid of small quads.  A single quad might have been
@@ -699,7 +934,15 @@ ProceduralGround::ProceduralGround(const float _range, const int n,
     specularColor = glm::vec3(1.0, 1.0, 1.0);
     shininess = 10.0;
     specularColor = glm::vec3(0.0, 0.0, 0.0);
-    xoff = range*( time(NULL)%1000 );
+    xoff = range*groundSeed;
+
+    MeshCache cache(Format("ground-%d", n),
+                    Format("ProceduralGround range=%.9g n=%d octaves=%.9g persistence=%.9g scale=%.9g low=%.9g high=%.9g xoff=%.9g",
+                           range, n, octaves, persistence, scale, low, high, xoff));
+    if (cache.Load(this)) {
+        ComputeSize();
+        MakeVAO();
+        return; }
 
     float h = 0.001;
     for (int i=0;  i<=n;  i++) {
@@ -716,7 +959,7 @@ ProceduralGround::ProceduralGround(const float _range, const int n,
             glm::vec3 dv(0.0, 1.0, (zv-z)/h);
             Nrm.push_back(glm::normalize(glm::cross(du,dv)));
             Tex.push_back(glm::vec2(s, t));
-            Tan.push_back(glm::vec3(1.0, 0.0, 0.0));
+            Tan.push_back(glm::vec4(1.0, 0.0, 0.0, 1.0));
             if (i>0 && j>0) {
                 pushquad(Tri,
                          (i-1)*(n+1) + (j-1),
@@ -724,8 +967,9 @@ ProceduralGround::ProceduralGround(const float _range, const int n,
                          (i  )*(n+1) + (j),
                          (i  )*(n+1) + (j-1)); } } }
 
-    vaoID = VaoFromTris(Pnt, Nrm, Tex, Tan, Tri);
-    count = Tri.size();
+    cache.Save(this);
+    ComputeSize();
+    MakeVAO();
 }
 
 float ProceduralGround::HeightAt(const float x, const float y)
@@ -757,7 +1001,7 @@ Quad::Quad(const int n)
             Pnt.push_back(glm::vec4(s*2.0*r-r, t*2.0*r-r, 0.0, 1.0));
             Nrm.push_back(glm::vec3(0.0, 0.0, 1.0));
             Tex.push_back(glm::vec2(s, t));
-            Tan.push_back(glm::vec3(1.0, 0.0, 0.0));
+            Tan.push_back(glm::vec4(1.0, 0.0, 0.0, 1.0));
             if (i>0 && j>0) {
                 pushquad(Tri,
                          (i-1)*(n+1) + (j-1),
@@ -10,7 +10,7 @@
 // position,        glm::vec4,   attribute #0
 // normal,          glm::vec3,   attribute #1
 // texture coord,   glm::vec3,   attribute #2
-// tangent,         glm::vec3,   attribute #3
+// tangent,         glm::vec4,   attribute #3  (w: bitangent sign)
 //
 // An instance of any of these shapes is create with a single call:
 //    unsigned int obj = CreateSphere(divisions, &quadCount);
@@ -24,7 +24,6 @@
 #define _SHAPES
 
 #include "transform.h"
-#include "rply.h"
 
 #include <vector>
 
@@ -35,11 +34,16 @@ public:
     // The OpenGL identifier of this VAO
     unsigned int vaoID;
 
+    // A second VAO of the position buffer and the indices alone, on
+    // vaoID's buffers, for passes that read nothing else;  made on
+    // first use.
+    unsigned int positionVaoID;
+
     // Data arrays
     std::vector<glm::vec4> Pnt;
     std::vector<glm::vec3> Nrm;
     std::vector<glm::vec2> Tex;
-    std::vector<glm::vec3> Tan;
+    std::vector<glm::vec4> Tan;     // w: sign of the bitangent, w*cross(N,T)
 
     // Lighting information
     glm::vec3 diffuseColor, specularColor;
@@ -49,20 +53,38 @@ public:
     std::vector<glm::ivec3> Tri;
     unsigned int count;
 
-    // Defined by SetTransform by scanning data arrays
+    // Defined by SetTransform by scanning data arrays.  bounded is
+    // set once minP/maxP hold the shape's box (by ComputeSize, or a
+    // MeshCache's Load or Save);  until then they mean nothing.
     glm::vec3 minP, maxP;
+    bool bounded;
     glm::vec3 center;
     float size;
     glm::mat4 modelTr;
     bool animate;
 
+    // True if the VAO holds GL_PATCHES for the tessellation stages
+    // rather than triangles.  Such a shape can only be drawn by a
+    // program that has tessellation shaders attached.
+    bool patches;
+
     // Constructor and destructor
-    Shape() :animate(false) {}
-    virtual ~Shape() {}
+    Shape() :vaoID(0), positionVaoID(0), count(0), bounded(false), animate(false), patches(false) {}
+    virtual ~Shape();
 
     virtual void ComputeSize();
+    void ComputeTransform();
+
+    // Fill Tan from Pnt, Nrm, Tex and Tri (see shapes.cpp).
+    void ComputeTangents();
     virtual void MakeVAO();
-    virtual void DrawVAO();
+
+    // Draw with every attribute, or with positionsOnly, only the
+    // position (attribute 0).
+    virtual void DrawVAO(const bool positionsOnly=false);
+
+    // Total size of the VAO's buffers on the card
+    size_t Bytes() const;
 };
 
 class Box: public Shape
@@ -96,6 +118,18 @@ public:
     Teapot(const int n);
 };
 
+// The Utah teapot as its 306 control points and 32 bicubic patches,
+// tessellated on the GPU by teapot.tesc/teapot.tese.
+class TeapotPatches: public Shape
+{
+public:
+    std::vector<unsigned int> PatchIdx;
+
+    TeapotPatches();
+    virtual void MakeVAO();
+    virtual void DrawVAO(const bool positionsOnly=false);
+};
+
 class Plane: public Shape
 {
 public:
@@ -130,10 +164,6 @@ class Ply: public Shape
 public:
     Ply(const char* name, const bool reverse=false);
     virtual ~Ply() {printf("destruct Ply\n");};
-    static int vertex_cb(p_ply_argument argument);
-    static int normal_cb(p_ply_argument argument);
-    static int texture_cb(p_ply_argument argument);
-    static int face_cb(p_ply_argument argument);
 };
 
 #endif
@@ -0,0 +1,20 @@
+/////////////////////////////////////////////////////////////////////////
+// Pixel shader for the sky, where no geometry was drawn
+////////////////////////////////////////////////////////////////////////
+#version 330
+
+out vec4 FragColor;
+
+in vec3 eyeVec;
+
+uniform int mode;
+uniform samplerCube skyTex, skyTex2;
+
+void main()
+{
+    // The sky maps hold linear radiance;  encode it for display as
+    // the G-buffer pass did for the old sky sphere.
+    vec3 V = normalize(eyeVec);
+    vec3 sky = mode == 2 ? texture(skyTex2, V).xyz : texture(skyTex, V).xyz;
+    FragColor = vec4(pow(max(sky, vec3(0.0)), vec3(1.0/2.2)), 1.0);
+}
@@ -0,0 +1,20 @@
+/////////////////////////////////////////////////////////////////////////
+// Vertex shader for the sky:  one triangle covering the screen, at the
+// far plane, with no vertex attributes (drawn with an empty VAO).
+////////////////////////////////////////////////////////////////////////
+#version 330
+
+uniform mat4 WorldProj, WorldInverse;
+
+out vec3 eyeVec;
+
+void main()
+{
+    // (-1,-1), (3,-1), (-1,3)
+    vec2 p = vec2(float((gl_VertexID & 1) << 2) - 1.0, float((gl_VertexID & 2) << 1) - 1.0);
+    gl_Position = vec4(p, 1.0, 1.0);
+
+    // Toward the eye, in world coordinates, as the objects' eyeVec
+    vec4 v = inverse(WorldProj)*vec4(p, 1.0, 1.0);
+    eyeVec = -mat3(WorldInverse)*(v.xyz/v.w);
+}
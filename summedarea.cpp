@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////
+// Summed-area tables in compute shaders (see summedarea.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include <glbinding/gl/gl.h>
+#include <glbinding/Binding.h>
+using namespace gl;
+
+#include "shader.h"
+#include "resources.h"
+#include "summedarea.h"
+
+#include <glu.h>                // For gluErrorString
+#define CHECKERROR {GLenum err = glGetError(); if (err != GL_NO_ERROR) { fprintf(stderr, "OpenGL error (at line summedarea.cpp:%d): %s\n", __LINE__, gluErrorString(err)); exit(-1);} }
+
+// Lines a group sums, as the shaders declare their sizes
+static const int groupLines = 8;
+
+SummedAreaTable::SummedAreaTable()
+    : width(0), height(0), layers(0), texture(0), source(SOURCE_COLOR),
+      resources(NULL), rows(NULL), columns(NULL)
+{}
+
+SummedAreaTable::~SummedAreaTable()
+{
+    if (!resources) return;
+    resources->programs.Release(rows);
+    resources->programs.Release(columns);
+    glDeleteTextures(1, &texture);
+}
+
+void SummedAreaTable::Create(Resources* _resources, const int w, const int h, const int _layers)
+{
+    if (_layers > MaxSatLayers) {
+        printf("SummedAreaTable takes %d layers at most, not %d\n", MaxSatLayers, _layers);
+        exit(-1); }
+
+    resources = _resources;
+    width = w;
+    height = h;
+    layers = _layers;
+
+    rows = resources->ComputeProgram("sat-h.comp", FilterSourceGLSL());
+    columns = resources->ComputeProgram("sat-v.comp");
+
+    // Integer textures are complete only with nearest filtering.
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA32UI, width, height, layers);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, (int)GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, (int)GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    CHECKERROR;
+}
+
+void SummedAreaTable::Build(const unsigned int src, const int* extent, const int count, const int* region)
+{
+    // Layers left as they are sum nothing.
+    int sizes[MaxSatLayers];
+    int n = 0;
+    for (int i=0;  i<count;  i++) {
+        bool clean = region && region[4*i] >= region[4*i+2];
+        sizes[i] = clean ? 0 : extent[i];
+        n = std::max(n, sizes[i]); }
+    if (n == 0)
+        return;
+    n = std::min(n, std::min(width, height));
+    int groups = (n + groupLines-1)/groupLines;
+
+    rows->Use();
+    int programId = rows->programId;
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, src);
+    int loc = glGetUniformLocation(programId, "src");
+    glUniform1i(loc, 0);
+    glBindImageTexture(1, texture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA32UI);
+    loc = glGetUniformLocation(programId, "dst");
+    glUniform1i(loc, 1);
+    loc = glGetUniformLocation(programId, "extent");
+    glUniform1iv(loc, count, sizes);
+    loc = glGetUniformLocation(programId, "source");
+    glUniform1i(loc, (int)source);
+    glDispatchCompute(1, groups, count);
+    rows->Unuse();
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    columns->Use();
+    programId = columns->programId;
+    glBindImageTexture(1, texture, 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA32UI);
+    loc = glGetUniformLocation(programId, "sat");
+    glUniform1i(loc, 1);
+    loc = glGetUniformLocation(programId, "extent");
+    glUniform1iv(loc, count, sizes);
+    glDispatchCompute(groups, 1, count);
+    columns->Unuse();
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    CHECKERROR;
+}
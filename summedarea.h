@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////
+// A summed-area table of the layers of a texture array:  each texel
+// holds the sum of every source texel above and to the left of it,
+// inclusive, so the sum over any box is four lookups,
+//    S(x1,y1) - S(x0-1,y1) - S(x1,y0-1) + S(x0-1,y0-1)
+// whatever the box's size.  Shaders can then filter with a box of any
+// width, pixel by pixel, with no blur pass to redo.
+//
+// Built by compute shaders as prefix sums:  along rows (sat-h.comp),
+// then along columns in place (sat-v.comp), each a parallel scan in
+// shared memory.
+//
+// Sums of floats lose the low bits of small boxes far from the
+// corner.  Instead, source texels (in [0,1]) are kept as 16 bit fixed
+// point and summed as 32 bit unsigned integers (GL_RGBA32UI), which
+// wrap around.  The four-lookup difference is exact modulo 2^32, so a
+// box's sum is exact as long as it fits:  boxes of up to 65536 texels
+// (256 on a side).
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _SUMMEDAREA_
+#define _SUMMEDAREA_
+
+#include "separablefilter.h"        // For FilterSource
+
+class Resources;
+class ShaderProgram;
+
+// Layers built in one Build (extent[] in sat-h.comp)
+const int MaxSatLayers = 4;
+
+class SummedAreaTable
+{
+ public:
+    int width, height, layers;
+    unsigned int texture;       // GL_TEXTURE_2D_ARRAY of GL_RGBA32UI sums
+    FilterSource source;        // What is summed of a source texel;  SOURCE_COLOR unless set
+
+    SummedAreaTable();
+    ~SummedAreaTable();
+
+    // Build the passes (shared through resources) and the table.
+    void Create(Resources* resources, const int w, const int h, const int layers);
+
+    // Sum the first count layers of src (a GL_TEXTURE_2D_ARRAY), layer
+    // i over its first extent[i] texels on a side.  With region (x0,
+    // y0, x1, y1 for each layer, as SeparableFilter::Apply takes), a
+    // layer whose region is empty is left as it is;  any change means
+    // summing the whole layer again.
+    void Build(const unsigned int src, const int* extent, const int count, const int* region=NULL);
+
+    size_t Bytes() const { return (size_t)width*height*layers*16; }
+
+ private:
+    Resources* resources;
+    ShaderProgram *rows, *columns;
+};
+
+#endif
@@ -0,0 +1,14 @@
+/////////////////////////////////////////////////////////////////////////
+// Vertex shader for the tessellated teapot.  The VAO holds only the
+// Bezier control points, which pass through unchanged to teapot.tesc.
+////////////////////////////////////////////////////////////////////////
+#version 400
+
+in vec4 vertex;
+
+out vec4 controlPoint;
+
+void main()
+{
+    controlPoint = vertex;
+}
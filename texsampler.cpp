@@ -0,0 +1,179 @@
+///////////////////////////////////////////////////////////////////////
+// CPU copies of textures, and their sampler (see texsampler.h).
+////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <algorithm>
+
+#define GLM_FORCE_RADIANS
+#define GLM_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "texsampler.h"
+
+////////////////////////////////////////////////////////////////////////
+// Four floats at a time:  one coordinate of four samples, or the RGBA
+// of one texel.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+typedef __m128 Quad;
+static inline Quad Load(const float* p) { return _mm_loadu_ps(p); }
+static inline void Store(float* p, const Quad a) { _mm_storeu_ps(p, a); }
+static inline Quad Set(const float a) { return _mm_set1_ps(a); }
+static inline Quad Add(const Quad a, const Quad b) { return _mm_add_ps(a, b); }
+static inline Quad Sub(const Quad a, const Quad b) { return _mm_sub_ps(a, b); }
+static inline Quad Mul(const Quad a, const Quad b) { return _mm_mul_ps(a, b); }
+static inline Quad Min(const Quad a, const Quad b) { return _mm_min_ps(a, b); }
+static inline Quad Max(const Quad a, const Quad b) { return _mm_max_ps(a, b); }
+
+// Truncate, then step down where that rounded up (negative values).
+static inline Quad Floor(const Quad a)
+{
+    Quad t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+}
+
+// a < b ? x : y, lane by lane
+static inline Quad SelectLess(const Quad a, const Quad b, const Quad x, const Quad y)
+{
+    Quad m = _mm_cmplt_ps(a, b);
+    return _mm_or_ps(_mm_and_ps(m, x), _mm_andnot_ps(m, y));
+}
+
+#else
+
+typedef glm::vec4 Quad;
+static inline Quad Load(const float* p) { return glm::vec4(p[0], p[1], p[2], p[3]); }
+static inline void Store(float* p, const Quad a) { p[0]=a[0];  p[1]=a[1];  p[2]=a[2];  p[3]=a[3]; }
+static inline Quad Set(const float a) { return glm::vec4(a); }
+static inline Quad Add(const Quad a, const Quad b) { return a + b; }
+static inline Quad Sub(const Quad a, const Quad b) { return a - b; }
+static inline Quad Mul(const Quad a, const Quad b) { return a * b; }
+static inline Quad Min(const Quad a, const Quad b) { return glm::min(a, b); }
+static inline Quad Max(const Quad a, const Quad b) { return glm::max(a, b); }
+static inline Quad Floor(const Quad a) { return glm::floor(a); }
+static inline Quad SelectLess(const Quad a, const Quad b, const Quad x, const Quad y)
+{
+    Quad r;
+    for (int k=0;  k<4;  k++) r[k] = a[k] < b[k] ? x[k] : y[k];
+    return r;
+}
+
+#endif
+
+static inline Quad Lerp(const Quad a, const Quad b, const Quad t)
+{
+    return Add(a, Mul(Sub(b, a), t));
+}
+
+// Whole texel coordinates x, on a level size texels across, brought
+// into [0,size) by the wrap mode.
+static inline Quad Wrap(const Quad x, const int size, const SamplerWrap wrap)
+{
+    Quad n = Set((float)size), last = Set((float)(size-1));
+    Quad r = x;
+    if (wrap == WRAP_REPEAT)
+        r = Sub(x, Mul(n, Floor(Mul(x, Set(1.0f/size)))));
+    else if (wrap == WRAP_MIRROR) {
+        Quad n2 = Set(2.0f*size);
+        Quad p = Sub(x, Mul(n2, Floor(Mul(x, Set(0.5f/size)))));
+        r = SelectLess(p, n, p, Sub(Sub(n2, Set(1.0f)), p)); }
+
+    // Also guards against rounding in the divisions above
+    return Min(Max(r, Set(0.0f)), last);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+TexSampler::TexSampler(const MipChain& chain, const SamplerWrap wrap, const SamplerFilter _filter)
+    : width(chain.width), height(chain.height), levels(chain.levels),
+      wrapU(wrap), wrapV(wrap), filter(_filter)
+{
+    size_t total = 0;
+    for (int i=0;  i<levels;  i++) {
+        offset[i] = total;
+        total += (size_t)chain.LevelWidth(i)*chain.LevelHeight(i)*4; }
+    texels.resize(total);
+    for (int i=0;  i<levels;  i++)
+        chain.Decode(i, &texels[offset[i]]);
+}
+
+// n (at most 4) samples of level i, with coordinates in u[0..3] and
+// v[0..3].  Coordinates and weights are found for all four lanes at
+// once;  then each sample is four texel loads and three blends (or
+// one load, for FILTER_NEAREST).
+void TexSampler::SampleLevel(const int i, const float* u, const float* v, const int n, glm::vec4* out) const
+{
+    int w = std::max(1, width >> i), h = std::max(1, height >> i);
+    const float* base = &texels[offset[i]];
+    Quad U = Mul(Load(u), Set((float)w)), V = Mul(Load(v), Set((float)h));
+
+    float x0[4], y0[4];
+    if (filter == FILTER_NEAREST) {
+        Store(x0, Wrap(Floor(U), w, wrapU));
+        Store(y0, Wrap(Floor(V), h, wrapV));
+        for (int k=0;  k<n;  k++)
+            Store(&out[k][0], Load(base + 4*((size_t)y0[k]*w + (size_t)x0[k])));
+        return; }
+
+    // Texel centers are at half-integers.
+    U = Sub(U, Set(0.5f));
+    V = Sub(V, Set(0.5f));
+    Quad fu = Floor(U), fv = Floor(V);
+    float x1[4], y1[4], ax[4], ay[4];
+    Store(ax, Sub(U, fu));
+    Store(ay, Sub(V, fv));
+    Store(x0, Wrap(fu, w, wrapU));
+    Store(x1, Wrap(Add(fu, Set(1.0f)), w, wrapU));
+    Store(y0, Wrap(fv, h, wrapV));
+    Store(y1, Wrap(Add(fv, Set(1.0f)), h, wrapV));
+
+    for (int k=0;  k<n;  k++) {
+        const float* r0 = base + 4*(size_t)y0[k]*w;
+        const float* r1 = base + 4*(size_t)y1[k]*w;
+        size_t c0 = 4*(size_t)x0[k], c1 = 4*(size_t)x1[k];
+        Quad a = Set(ax[k]);
+        Quad bottom = Lerp(Load(r0 + c0), Load(r0 + c1), a);
+        Quad top = Lerp(Load(r1 + c0), Load(r1 + c1), a);
+        Store(&out[k][0], Lerp(bottom, top, Set(ay[k]))); }
+}
+
+void TexSampler::Sample4(const float* u, const float* v, const int n, const float lod, glm::vec4* out) const
+{
+    float l = std::min(std::max(lod, 0.0f), (float)(levels-1));
+    if (filter != FILTER_TRILINEAR) {
+        SampleLevel((int)(l + 0.5f), u, v, n, out);
+        return; }
+
+    int i = (int)l;
+    float t = l - i;
+    SampleLevel(i, u, v, n, out);
+    if (t > 0.0f && i+1 < levels) {
+        glm::vec4 next[4];
+        SampleLevel(i+1, u, v, n, next);
+        for (int k=0;  k<n;  k++)
+            Store(&out[k][0], Lerp(Load(&out[k][0]), Load(&next[k][0]), Set(t))); }
+}
+
+glm::vec4 TexSampler::Sample(const glm::vec2& uv, const float lod) const
+{
+    float u[4] = { uv.x, uv.x, uv.x, uv.x };
+    float v[4] = { uv.y, uv.y, uv.y, uv.y };
+    glm::vec4 out;
+    Sample4(u, v, 1, lod, &out);
+    return out;
+}
+
+void TexSampler::Sample(const glm::vec2* uv, glm::vec4* out, const int n, const float lod) const
+{
+    for (int j=0;  j<n;  j+=4) {
+        int m = std::min(4, n-j);
+        float u[4], v[4];
+        for (int k=0;  k<4;  k++) {
+            const glm::vec2& p = uv[j + std::min(k, m-1)];
+            u[k] = p.x;
+            v[k] = p.y; }
+        Sample4(u, v, m, lod, out+j); }
+}
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////
+// A copy of a texture kept in main memory, with a sampler that filters
+// it as the graphics card would:  wrap modes, and nearest, bilinear or
+// trilinear filtering over the mipmap levels.  For work done on the
+// CPU:  baking, software rendering, and effects that read a texture.
+//
+// Every level is decoded to float RGBA (see MipChain::Decode), one SSE
+// register a texel, so a bilinear sample is four loads and three
+// blends.  The batch Sample works out the coordinates and weights of
+// four samples at once.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _TEXSAMPLER_
+#define _TEXSAMPLER_
+
+#include <vector>
+
+#include "mipchain.h"
+
+// As GL_REPEAT, GL_CLAMP_TO_EDGE and GL_MIRRORED_REPEAT
+enum SamplerWrap { WRAP_REPEAT, WRAP_CLAMP, WRAP_MIRROR };
+
+// FILTER_NEAREST and FILTER_BILINEAR read the level nearest lod (as
+// GL_NEAREST_MIPMAP_NEAREST and GL_LINEAR_MIPMAP_NEAREST);
+// FILTER_TRILINEAR blends the two levels around it.
+enum SamplerFilter { FILTER_NEAREST, FILTER_BILINEAR, FILTER_TRILINEAR };
+
+class TexSampler
+{
+ public:
+    int width, height;          // Of level 0
+    int levels;
+    SamplerWrap wrapU, wrapV;
+    SamplerFilter filter;
+
+    TexSampler(const MipChain& chain, const SamplerWrap wrap=WRAP_REPEAT,
+               const SamplerFilter _filter=FILTER_TRILINEAR);
+
+    // The filtered color at texture coordinates uv, from mipmap level
+    // lod (0 is the full image).  As with OpenGL textures, (0,0) is
+    // the corner of the image's first row.
+    glm::vec4 Sample(const glm::vec2& uv, const float lod=0.0f) const;
+
+    // Sample each of n coordinates into out, at the same lod.
+    void Sample(const glm::vec2* uv, glm::vec4* out, const int n, const float lod=0.0f) const;
+
+    size_t Bytes() const { return texels.size()*sizeof(float); }
+
+ private:
+    std::vector<float> texels;          // Every level, RGBA
+    size_t offset[MaxMipLevels];        // Of each level in texels, in floats
+
+    void SampleLevel(const int i, const float* u, const float* v, const int n, glm::vec4* out) const;
+    void Sample4(const float* u, const float* v, const int n, const float lod, glm::vec4* out) const;
+};
+
+#endif
@@ -7,6 +7,8 @@
 #include "math.h"
 #include <fstream>
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
 
 #include <glbinding/gl/gl.h>
 #include <glbinding/Binding.h>
@@ -25,28 +27,181 @@ using namespace gl;
 #include <glu.h>                // For gluErrorString
 #define CHECKERROR {GLenum err = glGetError(); if (err != GL_NO_ERROR) { fprintf(stderr, "OpenGL error (at line texture.cpp:%d): %s\n", __LINE__, gluErrorString(err)); exit(-1);} }
 
-Texture::Texture(const std::string &path) : textureId(0)
+Texture::Texture(const std::string &path, const bool srgb, const bool _keep)
+    : textureId(0), target((unsigned int)GL_TEXTURE_2D), placeholder(0.5f, 0.5f, 0.5f, 1.0f),
+      sampler(NULL), keep(_keep), ready(false),
+      bytes(0), internalFormat(0), levels(0)
 {
     stbi_set_flip_vertically_on_load(true);
-    image = stbi_load(path.c_str(), &width, &height, &depth, 4);
+    MipChain chain;
+    if (!chain.Load(path, srgb)) {
+        printf("\nRead error on file %s:\n  %s\n\n", path.c_str(), chain.reason);
+        exit(-1); }
+    printf("%d %d %d %s\n", 4, chain.width, chain.height, path.c_str());
+
+    Upload(chain);
+    if (keep)
+        sampler = new TexSampler(chain);
+}
+
+Texture::Texture(const glm::vec4& _placeholder, const bool cube)
+    : textureId(0), target((unsigned int)(cube ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D)),
+      placeholder(_placeholder), sampler(NULL), keep(false), ready(false),
+      bytes(cube ? 24 : 4), internalFormat((unsigned int)GL_RGBA8), levels(1)
+{
+    unsigned char texel[4];
+    for (int c=0;  c<4;  c++)
+        texel[c] = (unsigned char)(255.0f*glm::clamp(placeholder[c], 0.0f, 1.0f) + 0.5f);
+
+    width = height = 1;
     depth = 4;
-    printf("%d %d %d %s\n", depth, width, height, path.c_str());
-    if (!image) {
-        printf("\nRead error on file %s:\n  %s\n\n", path.c_str(), stbi_failure_reason());
+    glGenTextures(1, &textureId);
+    glBindTexture((GLenum)target, textureId);
+    glTexStorage2D((GLenum)target, 1, GL_RGBA8, 1, 1);
+    if (cube)
+        for (int f=0;  f<6;  f++)
+            glTexSubImage2D((GLenum)((int)GL_TEXTURE_CUBE_MAP_POSITIVE_X + f), 0, 0, 0, 1, 1,
+                            GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    glTexParameteri((GLenum)target, GL_TEXTURE_MAG_FILTER, (int)GL_LINEAR);
+    glTexParameteri((GLenum)target, GL_TEXTURE_MIN_FILTER, (int)GL_LINEAR);
+    glBindTexture((GLenum)target, 0);
+    CHECKERROR;
+}
+
+Texture::~Texture()
+{
+    if (textureId)
+        glDeleteTextures(1, &textureId);
+    delete sampler;
+}
+
+// The levels are copied into one pixel buffer object, and the texture
+// is filled from that (with glCompressedTexSubImage2D for a
+// block-compressed chain), so the transfer to the card can proceed after
+// this returns.  Storage is immutable (glTexStorage2D), so a new
+// texture object replaces whatever textureId held before.
+void Texture::Upload(const MipChain& chain)
+{
+    GLsizeiptr size = 0;
+    for (int i=0;  i<chain.levels;  i++)
+        size += chain.LevelSize(i);
+
+    GLuint pbo;
+    glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    char* dst = (char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!dst) {
+        CHECKERROR;
+        fprintf(stderr, "Could not map a %ld byte pixel buffer for a texture upload\n", (long)size);
         exit(-1); }
+    size_t offset = 0;
+    for (int i=0;  i<chain.levels;  i++) {
+        memcpy(dst + offset, chain.level[i], chain.LevelSize(i));
+        offset += chain.LevelSize(i); }
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    GLenum internal = GL_RGBA8;
+    switch (chain.format) {
+    case MIP_BC1: internal = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;  break;
+    case MIP_BC3: internal = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;  break;
+    case MIP_BC5: internal = GL_COMPRESSED_RG_RGTC2;  break;
+    case MIP_RGB9E5: internal = GL_RGB9_E5;  break;
+    case MIP_R11G11B10F: internal = GL_R11F_G11F_B10F;  break;
+    case MIP_BC6H: internal = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;  break;
+    default: break; }
 
-    // Here we create MIPMAP and set some useful modes for the texture
-    glGenTextures(1, &textureId);   // Get an integer id for this texture from OpenGL
-    glBindTexture(GL_TEXTURE_2D, textureId);
-    glTexImage2D(GL_TEXTURE_2D, 0, (GLint)GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 10);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexStorage2D(GL_TEXTURE_2D, chain.levels, internal, chain.width, chain.height);
+    offset = 0;
+    for (int i=0;  i<chain.levels;  i++) {
+        if (chain.format == MIP_RGBA8)
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, chain.LevelWidth(i), chain.LevelHeight(i),
+                            GL_RGBA, GL_UNSIGNED_BYTE, (const void*)offset);
+        else if (chain.format == MIP_RGB9E5)
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, chain.LevelWidth(i), chain.LevelHeight(i),
+                            GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, (const void*)offset);
+        else if (chain.format == MIP_R11G11B10F)
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, chain.LevelWidth(i), chain.LevelHeight(i),
+                            GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV, (const void*)offset);
+        else
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, chain.LevelWidth(i), chain.LevelHeight(i),
+                                      internal, (GLsizei)chain.LevelSize(i), (const void*)offset);
+        offset += chain.LevelSize(i); }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &pbo);   // Freed by the driver once the copy is done
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (int)GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (int)GL_LINEAR_MIPMAP_LINEAR);  
     glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(image);
+    CHECKERROR;
 
+    if (textureId)
+        glDeleteTextures(1, &textureId);
+    textureId = id;
+    width = chain.width;
+    height = chain.height;
+    depth = 4;
+    bytes = size;
+    internalFormat = (unsigned int)internal;
+    levels = chain.levels;
+    ready = true;
+}
+
+// As Upload, but the faces of each level go one after another.  The
+// texels are RGB9_E5 already, so no conversion is left to the driver.
+void Texture::UploadCube(const EnvCube& env)
+{
+    GLsizeiptr size = env.Bytes();
+
+    GLuint pbo;
+    glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    char* dst = (char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!dst) {
+        CHECKERROR;
+        fprintf(stderr, "Could not map a %ld byte pixel buffer for a texture upload\n", (long)size);
+        exit(-1); }
+    memcpy(dst, env.Face(0, 0), size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, id);
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, env.levels, GL_RGB9_E5, env.size, env.size);
+    for (int i=0;  i<env.levels;  i++) {
+        int n = env.LevelSize(i);
+        for (int f=0;  f<6;  f++) {
+            size_t offset = (const char*)env.Face(i, f) - (const char*)env.Face(0, 0);
+            glTexSubImage2D((GLenum)((int)GL_TEXTURE_CUBE_MAP_POSITIVE_X + f), i, 0, 0, n, n,
+                            GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, (const void*)offset); } }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &pbo);
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, (int)GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, (int)GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, (int)GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, (int)GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    CHECKERROR;
+
+    if (textureId)
+        glDeleteTextures(1, &textureId);
+    textureId = id;
+    target = (unsigned int)GL_TEXTURE_CUBE_MAP;
+    width = height = env.size;
+    depth = 4;
+    bytes = size;
+    internalFormat = (unsigned int)GL_RGB9_E5;
+    levels = env.levels;
+    ready = true;
 }
 
 // Make a texture availabe to a shader program.  The unit parameter is
@@ -56,7 +211,7 @@ Texture::Texture(const std::string &path) : textureId(0)
 void Texture::Bind(const int unit, const int programId, const std::string& name)
 {
     glActiveTexture((gl::GLenum)((int)GL_TEXTURE0 + unit));
-    glBindTexture(GL_TEXTURE_2D, textureId);
+    glBindTexture((GLenum)target, textureId);
     int loc = glGetUniformLocation(programId, name.c_str());
     glUniform1i(loc, unit);
 }
@@ -64,11 +219,174 @@ void Texture::Bind(const int unit, const int programId, const std::string& name)
 // Unbind a texture from a texture unit whne no longer needed.
 void Texture::Unbind()
 {  
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture((GLenum)target, 0);
 }
 
 glm::vec3 Texture::GetTexel(float u, float v)
 {
-    int i = int(v*height)*width*depth + int(u*width)*depth;
-    return glm::vec3(image[i]/127.0, image[i+1]/127.0, image[i+2]/127.0);
+    if (!sampler)
+        return glm::vec3(placeholder);
+    return glm::vec3(sampler->Sample(glm::vec2(u, v)));
+}
+
+////////////////////////////////////////////////////////////////////////
+// TextureLoader
+
+TextureLoader::TextureLoader(ResourceCache<Texture>* _cache, const int threads)
+    : cache(_cache), outstanding(0), quit(false)
+{
+    // stb_image keeps this setting in a global, so it is set once here
+    // before any worker can be decoding.
+    stbi_set_flip_vertically_on_load(true);
+
+    int n = threads > 0 ? threads : (int)std::thread::hardware_concurrency();
+    n = std::max(1, n);
+    for (int i=0;  i<n;  i++)
+        workers.push_back(std::thread(&TextureLoader::Work, this));
+}
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        quit = true;
+    }
+    wake.notify_all();
+    for (size_t i=0;  i<workers.size();  i++)
+        workers[i].join();
+
+    for (size_t i=0;  i<pending.size();  i++)
+        delete pending[i];
+    for (size_t i=0;  i<decoded.size();  i++) {
+        delete decoded[i]->sampler;
+        delete decoded[i]; }
+}
+
+Texture* TextureLoader::Load(const std::string& path, const glm::vec4& placeholder, const bool srgb,
+                             const bool keep)
+{
+    std::string key = path + (srgb ? "" : " (linear)");
+    Texture* texture = cache->Acquire(key);
+    if (texture) {
+        if (keep && !texture->keep) {
+            std::lock_guard<std::mutex> hold(lock);
+            texture->keep = true; }
+
+        // Already uploaded:  its chain is gone, but mapping the cached
+        // one again is quick.
+        if (keep && texture->ready && !texture->sampler) {
+            MipChain chain;
+            if (chain.Load(path, srgb))
+                texture->sampler = new TexSampler(chain); }
+        return texture; }
+    return Queue(path, key, placeholder, srgb, keep, false);
+}
+
+Texture* TextureLoader::LoadCube(const std::string& path, const glm::vec4& placeholder)
+{
+    std::string key = path + " (cube)";
+    Texture* texture = cache->Acquire(key);
+    if (texture) return texture;
+    return Queue(path, key, placeholder, false, false, true);
+}
+
+// A placeholder in the cache under key, and a job to replace it.
+Texture* TextureLoader::Queue(const std::string& path, const std::string& key, const glm::vec4& placeholder,
+                              const bool srgb, const bool keep, const bool cube)
+{
+    Texture* texture = cache->Add(key, new Texture(placeholder, cube));
+    texture->keep = keep;
+
+    // The job holds the texture too, so it cannot be evicted while
+    // a worker is reading it.
+    cache->Acquire(key);
+    Job* job = new Job;
+    job->path = path;
+    job->texture = texture;
+    job->srgb = srgb;
+    job->cube = cube;
+    job->ok = false;
+    job->sampler = NULL;
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        pending.push_back(job);
+        outstanding++;
+    }
+    wake.notify_one();
+    return texture;
+}
+
+void TextureLoader::Work()
+{
+    for (;;) {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> hold(lock);
+            while (!quit && pending.empty())
+                wake.wait(hold);
+            if (quit) return;
+            job = pending.front();
+            pending.pop_front();
+        }
+
+        if (job->cube)
+            job->ok = job->env.Load(job->path);
+        else
+            job->ok = job->chain.Load(job->path, job->srgb);
+
+        // If keep is set only after this, Update makes the copy.
+        bool keep;
+        {
+            std::lock_guard<std::mutex> hold(lock);
+            keep = job->texture->keep;
+        }
+        if (job->ok && keep)
+            job->sampler = new TexSampler(job->chain);
+
+        std::lock_guard<std::mutex> hold(lock);
+        decoded.push_back(job); }
+}
+
+void TextureLoader::Update(const size_t budget)
+{
+    size_t sent = 0;
+    while (sent < budget) {
+        Job* job;
+        {
+            std::lock_guard<std::mutex> hold(lock);
+            if (decoded.empty()) return;
+            job = decoded.front();
+            decoded.pop_front();
+            outstanding--;
+        }
+
+        if (!job->ok) {
+            printf("\nRead error on file %s:\n  %s\n\n", job->path.c_str(),
+                   job->cube ? job->env.reason : job->chain.reason);
+            exit(-1); }
+
+        if (job->cube) {
+            printf("cube %d %d %s\n", job->env.size, job->env.levels, job->path.c_str());
+            job->texture->UploadCube(job->env);
+            cache->Release(job->texture);
+            sent += job->env.Bytes();
+            delete job;
+            continue; }
+
+        printf("%d %d %d %s\n", 4, job->chain.width, job->chain.height, job->path.c_str());
+        job->texture->Upload(job->chain);
+        if (job->texture->keep && !job->texture->sampler)
+            job->texture->sampler = job->sampler ? job->sampler : new TexSampler(job->chain);
+        else
+            delete job->sampler;
+        cache->Release(job->texture);
+        for (int i=0;  i<job->chain.levels;  i++)
+            sent += job->chain.LevelSize(i);
+        delete job; }
+}
+
+int TextureLoader::Outstanding()
+{
+    std::lock_guard<std::mutex> hold(lock);
+    return outstanding;
 }
@@ -1,12 +1,27 @@
 ///////////////////////////////////////////////////////////////////////
 // A slight encapsulation of an OpenGL texture. This contains a method
 // to read an image file into a texture, and methods to bind a texture
-// to a shader for use, and unbind when done.
+// to a shader for use, and unbind when done.  A TextureLoader reads
+// many image files in the background.  Mipmaps come precomputed from a
+// MipChain (see mipchain.h), and environment cube maps from an
+// EnvCube (see envcube.h).
 ////////////////////////////////////////////////////////////////////////
 
 #ifndef _TEXTURE_
 #define _TEXTURE_
 
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "mipchain.h"
+#include "envcube.h"
+#include "texsampler.h"
+#include "resources.h"
+
 
 // This class reads an image from a file, stores it on the graphics
 // card as a texture, and stores the (small integer) texture id which
@@ -17,13 +32,102 @@ class Texture
 {
  public:
     unsigned int textureId;
+    unsigned int target;        // GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
     int width, height, depth;
-    unsigned char* image;
-    Texture(const std::string &filename);
+    glm::vec4 placeholder;      // Color shown until Upload
+    TexSampler* sampler;        // A copy kept in main memory, or NULL
+    bool keep;                  // Keep a copy when the image arrives
+    bool ready;                 // False while showing a placeholder
+    size_t bytes;               // Of all levels, as stored on the card
+    unsigned int internalFormat;    // As given to glTexStorage2D
+    int levels;
+
+    // srgb:  as for MipChain::Load.  keep:  also make sampler.
+    Texture(const std::string &filename, const bool srgb=true, const bool keep=false);
+
+    // A 1x1 texture (each face 1x1 if cube) of the given color, to
+    // stand in until Upload.
+    Texture(const glm::vec4& placeholder, const bool cube=false);
+    ~Texture();
+
+    size_t Bytes() const { return bytes; }
+
+    // Replace the texture's contents with all levels of a chain.
+    void Upload(const MipChain& chain);
+
+    // Replace the contents of a cube map texture with all levels of
+    // every face.
+    void UploadCube(const EnvCube& env);
 
     void Bind(const int unit, const int programId, const std::string& name);
     void Unbind();
+
+    // The bilinearly filtered color at (u,v) of level 0, from sampler;
+    // the placeholder color if there is no copy (yet).
     glm::vec3 GetTexel(float u, float v);
 };
 
+// Reads image files into MipChains on a pool of worker threads (mapping
+// a cached chain, or decoding and filtering the source on first use).
+// Load returns at once with a placeholder Texture;  the main thread
+// calls Update each frame to upload whatever has been read since,
+// through a pixel buffer object into immutable storage, and the
+// Texture switches to the real image.  The worker threads make no
+// OpenGL calls.  Textures are kept in a ResourceCache, keyed by path
+// and srgb.  A texture loaded with keep also gets a copy in main
+// memory (Texture::sampler), decoded by the worker too.
+class TextureLoader
+{
+ public:
+    // threads == 0 means one per hardware thread.
+    TextureLoader(ResourceCache<Texture>* _cache, const int threads=0);
+    ~TextureLoader();
+
+    // Loading the same path (and srgb) again returns the same Texture,
+    // held once more in the cache;  give it back with cache->Release.
+    // srgb:  as for MipChain::Load.  keep:  also give the texture a
+    // sampler, even if it was first loaded without.
+    Texture* Load(const std::string& path,
+                  const glm::vec4& placeholder=glm::vec4(0.5f, 0.5f, 0.5f, 1.0f),
+                  const bool srgb=true, const bool keep=false);
+
+    // Upload finished chains, stopping after about budget bytes so a
+    // frame is never held up for long.  Main thread only.
+    void Update(const size_t budget=32<<20);
+
+    // An equirectangular image file as a GL_TEXTURE_CUBE_MAP, resampled
+    // by a worker (see envcube.h).  Cached as Load, under its own key.
+    Texture* LoadCube(const std::string& path,
+                      const glm::vec4& placeholder=glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+
+    // Number of requested textures not yet uploaded.
+    int Outstanding();
+
+ private:
+    struct Job
+    {
+        std::string path;
+        Texture* texture;
+        bool srgb;
+        bool cube;              // Fill env rather than chain
+        bool ok;                // chain (or env) is filled, else its reason says why
+        MipChain chain;
+        EnvCube env;
+        TexSampler* sampler;    // Made by the worker if texture->keep
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<Job*> pending;   // Waiting for a worker
+    std::deque<Job*> decoded;   // Waiting for Update
+    ResourceCache<Texture>* cache;
+    int outstanding;
+    bool quit;
+
+    Texture* Queue(const std::string& path, const std::string& key, const glm::vec4& placeholder,
+                   const bool srgb, const bool keep, const bool cube);
+    void Work();
+};
+
 #endif
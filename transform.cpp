@@ -134,6 +134,21 @@ glm::mat4 Perspective(const float rx, const float ry,
 }
 
 
+// Returns an orthographic projection matrix:  x in [-rx,rx], y in
+// [-ry,ry] and depth (along -z) in [front,back] to the unit cube.
+glm::mat4 Orthographic(const float rx, const float ry,
+             const float front, const float back)
+{
+    glm::mat4 P(1.0f);
+
+    P[0][0] = 1 / rx;
+    P[1][1] = 1 / ry;
+    P[2][2] = -2 / (back - front);
+    P[3][2] = -(back + front) / (back - front);
+
+    return P;
+}
+
 glm::mat4 MatrixMult(glm::mat4 m1, glm::mat4 m2)
 {
     glm::mat4 M;
@@ -16,6 +16,8 @@ glm::mat4 Scale(const float x, const float y, const float z);
 glm::mat4 Translate(const float x, const float y, const float z);
 glm::mat4 Perspective(const float rx, const float ry,
                  const float front, const float back);
+glm::mat4 Orthographic(const float rx, const float ry,
+                 const float front, const float back);
 glm::mat4 LookAt(const glm::vec3 Eye, const glm::vec3 Center, const glm::vec3 Up);
 
 float* Pntr(glm::mat4& m);